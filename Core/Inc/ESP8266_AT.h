@@ -18,9 +18,176 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include "stm32f4xx_hal_uart.h"
+#include "stm32f4xx_hal.h"
+
+#define ESP8266_AT_GSLP_MAX_MS 4294967UL // 2^32 us
+#define ESP8266_AT_WAKE_SETTLE_MS 5
+#define ESP8266_AT_NO_GPIO 0xFF
+#define ESP8266_AT_MAX_BAUD 4608000UL
+#define ESP8266_AT_RFPOWER_MAX 82
+#define ESP8266_AT_VDD33_MIN 1900
+#define ESP8266_AT_VDD33_MAX 3300
+#define ESP8266_AT_BAUD_TOLERANCE_PERMILLE 20
+#define ESP8266_AT_LINK_MAX 4       // highest link id with CIPMUX=1
+#define ESP8266_AT_CIPSEND_MAX 2048 // payload bytes per CIPSEND
+
+#define ESP8266_AT_LINE_MAX 96 // longest command line, CR/LF included
+
+// the UART interrupt path and the parser run from SRAM, free of flash
+// wait states, when ESP8266_AT_RAM_ISR is defined. The startup code
+// copies .RamFunc along with .data, see STM32F446RETX_FLASH.ld
+#ifdef ESP8266_AT_RAM_ISR
+#define ESP8266_AT_RAMFUNC __RAM_FUNC
+#else
+#define ESP8266_AT_RAMFUNC
+#endif
+
+// command forms, combined into the forms column of ESP8266_AT_COMMANDS
+#define ESP8266_AT_EXEC 0x01   // AT+X
+#define ESP8266_AT_QUERY 0x02  // AT+X?
+#define ESP8266_AT_SET 0x04    // AT+X=<args>
+#define ESP8266_AT_INLINE 0x08 // with SET: arguments follow the verb directly, ATE0
+
+// parameter descriptors for the params column
+#define ESP8266_AT_UINT(min, max) {ESP8266_AT_PARAM_UINT, (min), (max)},
+#define ESP8266_AT_STRING(max_len) {ESP8266_AT_PARAM_STRING, 0, (max_len)},
+#define ESP8266_AT_IPV4 {ESP8266_AT_PARAM_IPV4, 0, 0},
+#define ESP8266_AT_MAC {ESP8266_AT_PARAM_MAC, 0, 0},
 
-#define _Transmit(uart, str, timeout) HAL_UART_Transmit(&uart, (uint8_t *)strcat(str, "\r\n"), strlen(strcat(str, "\r\n")), timeout)
+/*
+ * Every command the driver knows, in one place:
+ * X(name, verb, forms, timeout in ms, reply prefix, required args, (params))
+ * The reply prefix starts the information line a query or command
+ * answers with before OK, empty when the command only answers OK.
+ * Params lists every argument of the SET form in order; arguments past
+ * the required count are optional. A verb whose forms take arguments in
+ * different positions gets a row per form, CIPSEND and CIPSEND_MUX;
+ * a raw line maps to the first of them.
+ */
+#define ESP8266_AT_COMMANDS(X)                                                        \
+    X(AT, "AT", ESP8266_AT_EXEC, 1000, "", 0, ())                                     \
+    X(RST, "AT+RST", ESP8266_AT_EXEC, 2000, "", 0, ())                                \
+    X(GMR, "AT+GMR", ESP8266_AT_EXEC, 1000, "", 0, ())                                \
+    X(GSLP, "AT+GSLP", ESP8266_AT_SET, 1000, "", 1,                                   \
+      (ESP8266_AT_UINT(0, ESP8266_AT_GSLP_MAX_MS)))                                   \
+    X(ATE, "ATE", ESP8266_AT_SET | ESP8266_AT_INLINE, 1000, "", 1,                    \
+      (ESP8266_AT_UINT(0, 1)))                                                        \
+    X(RESTORE, "AT+RESTORE", ESP8266_AT_EXEC, 2000, "", 0, ())                        \
+    X(UART_CUR, "AT+UART_CUR", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000, "+UART_CUR:", \
+      5, (ESP8266_AT_UINT(110, ESP8266_AT_MAX_BAUD) ESP8266_AT_UINT(5, 8)             \
+          ESP8266_AT_UINT(1, 3) ESP8266_AT_UINT(0, 2) ESP8266_AT_UINT(0, 3)))         \
+    X(UART_DEF, "AT+UART_DEF", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000, "+UART_DEF:", \
+      5, (ESP8266_AT_UINT(110, ESP8266_AT_MAX_BAUD) ESP8266_AT_UINT(5, 8)             \
+          ESP8266_AT_UINT(1, 3) ESP8266_AT_UINT(0, 2) ESP8266_AT_UINT(0, 3)))         \
+    X(SLEEP, "AT+SLEEP", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000, "+SLEEP:", 1,       \
+      (ESP8266_AT_UINT(0, 2)))                                                        \
+    X(WAKEUPGPIO, "AT+WAKEUPGPIO", ESP8266_AT_SET, 1000, "", 3,                       \
+      (ESP8266_AT_UINT(0, 1) ESP8266_AT_UINT(0, 15) ESP8266_AT_UINT(0, 1)             \
+           ESP8266_AT_UINT(0, 15) ESP8266_AT_UINT(0, 1)))                             \
+    X(RFPOWER, "AT+RFPOWER", ESP8266_AT_SET, 1000, "", 1,                             \
+      (ESP8266_AT_UINT(0, ESP8266_AT_RFPOWER_MAX)))                                   \
+    X(RFVDD, "AT+RFVDD", ESP8266_AT_EXEC | ESP8266_AT_QUERY | ESP8266_AT_SET, 1000,   \
+      "+RFVDD:", 1, (ESP8266_AT_UINT(ESP8266_AT_VDD33_MIN, ESP8266_AT_VDD33_MAX)))    \
+    X(SYSRAM, "AT+SYSRAM", ESP8266_AT_QUERY, 1000, "+SYSRAM:", 0, ())                 \
+    X(SYSADC, "AT+SYSADC", ESP8266_AT_QUERY, 1000, "+SYSADC:", 0, ())                 \
+    X(SYSIOSETCFG, "AT+SYSIOSETCFG", ESP8266_AT_SET, 1000, "", 3,                     \
+      (ESP8266_AT_UINT(0, 15) ESP8266_AT_UINT(0, 4) ESP8266_AT_UINT(0, 1)))           \
+    X(SYSIOGETCFG, "AT+SYSIOGETCFG", ESP8266_AT_SET, 1000, "+SYSIOGETCFG:", 1,        \
+      (ESP8266_AT_UINT(0, 15)))                                                       \
+    X(SYSGPIODIR, "AT+SYSGPIODIR", ESP8266_AT_SET, 1000, "", 2,                       \
+      (ESP8266_AT_UINT(0, 15) ESP8266_AT_UINT(0, 1)))                                 \
+    X(SYSGPIOWRITE, "AT+SYSGPIOWRITE", ESP8266_AT_SET, 1000, "", 2,                   \
+      (ESP8266_AT_UINT(0, 15) ESP8266_AT_UINT(0, 1)))                                 \
+    X(SYSGPIOREAD, "AT+SYSGPIOREAD", ESP8266_AT_SET, 1000, "+SYSGPIOREAD:", 1,        \
+      (ESP8266_AT_UINT(0, 15)))                                                       \
+    X(SYSMSG_CUR, "AT+SYSMSG_CUR", ESP8266_AT_SET, 1000, "", 1,                       \
+      (ESP8266_AT_UINT(0, 3)))                                                        \
+    X(SYSMSG_DEF, "AT+SYSMSG_DEF", ESP8266_AT_SET, 1000, "", 1,                       \
+      (ESP8266_AT_UINT(0, 3)))                                                        \
+    X(CWMODE_CUR, "AT+CWMODE_CUR", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000,           \
+      "+CWMODE_CUR:", 1, (ESP8266_AT_UINT(1, 3)))                                     \
+    X(CWMODE_DEF, "AT+CWMODE_DEF", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000,           \
+      "+CWMODE_DEF:", 1, (ESP8266_AT_UINT(1, 3)))                                     \
+    X(CWJAP_CUR, "AT+CWJAP_CUR", ESP8266_AT_QUERY | ESP8266_AT_SET, 20000,            \
+      "+CWJAP_CUR:", 2, (ESP8266_AT_STRING(32) ESP8266_AT_STRING(64)                  \
+                             ESP8266_AT_MAC))                                         \
+    X(CWJAP_DEF, "AT+CWJAP_DEF", ESP8266_AT_QUERY | ESP8266_AT_SET, 20000,            \
+      "+CWJAP_DEF:", 2, (ESP8266_AT_STRING(32) ESP8266_AT_STRING(64)                  \
+                             ESP8266_AT_MAC))                                         \
+    X(CWDHCP_DEF, "AT+CWDHCP_DEF", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000,           \
+      "+CWDHCP_DEF:", 2, (ESP8266_AT_UINT(0, 2) ESP8266_AT_UINT(0, 1)))               \
+    X(CWAUTOCONN, "AT+CWAUTOCONN", ESP8266_AT_SET, 1000, "", 1,                       \
+      (ESP8266_AT_UINT(0, 1)))                                                        \
+    X(CIPSTA_DEF, "AT+CIPSTA_DEF", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000,           \
+      "+CIPSTA_DEF:", 1, (ESP8266_AT_IPV4 ESP8266_AT_IPV4 ESP8266_AT_IPV4))           \
+    X(CIPSSLSIZE, "AT+CIPSSLSIZE", ESP8266_AT_SET, 1000, "", 1,                       \
+      (ESP8266_AT_UINT(2048, 4096)))                                                  \
+    X(CIPMUX, "AT+CIPMUX", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000, "+CIPMUX:", 1,    \
+      (ESP8266_AT_UINT(0, 1)))                                                        \
+    X(CIPMODE, "AT+CIPMODE", ESP8266_AT_QUERY | ESP8266_AT_SET, 1000, "+CIPMODE:",    \
+      1, (ESP8266_AT_UINT(0, 1)))                                                     \
+    X(PING, "AT+PING", ESP8266_AT_SET, 5000, "+", 1, (ESP8266_AT_STRING(64)))         \
+    X(CIPDOMAIN, "AT+CIPDOMAIN", ESP8266_AT_SET, 10000, "+CIPDOMAIN:", 1,             \
+      (ESP8266_AT_STRING(64)))                                                        \
+    X(CIPSTART, "AT+CIPSTART", ESP8266_AT_SET, 10000, "", 3,                          \
+      (ESP8266_AT_STRING(3) ESP8266_AT_STRING(64) ESP8266_AT_UINT(0, 65535)           \
+           ESP8266_AT_UINT(0, 7200)))                                                 \
+    X(CIPSEND, "AT+CIPSEND", ESP8266_AT_SET, 1000, "", 1,                             \
+      (ESP8266_AT_UINT(1, ESP8266_AT_CIPSEND_MAX)))                                   \
+    X(CIPSEND_MUX, "AT+CIPSEND", ESP8266_AT_SET, 1000, "", 2,                         \
+      (ESP8266_AT_UINT(0, ESP8266_AT_LINK_MAX)                                        \
+           ESP8266_AT_UINT(1, ESP8266_AT_CIPSEND_MAX)))                               \
+    X(CIPCLOSE, "AT+CIPCLOSE", ESP8266_AT_EXEC | ESP8266_AT_SET, 5000, "", 1,         \
+      (ESP8266_AT_UINT(0, 5)))
+
+typedef enum
+{
+#define X(name, verb, forms, timeout, reply, required, params) ESP8266_AT_CMD_##name,
+    ESP8266_AT_COMMANDS(X)
+#undef X
+    ESP8266_AT_CMD_OTHER,
+    ESP8266_AT_CMD_COUNT
+} ESP8266_AT_CmdId;
+
+typedef enum
+{
+    ESP8266_AT_PARAM_UINT,
+    ESP8266_AT_PARAM_STRING, // sent quoted, max is its longest length
+    ESP8266_AT_PARAM_IPV4,   // sent quoted as a.b.c.d
+    ESP8266_AT_PARAM_MAC     // sent quoted as aa:bb:cc:dd:ee:ff
+} ESP8266_AT_ParamType;
+
+typedef struct
+{
+    ESP8266_AT_ParamType type;
+    uint32_t min;
+    uint32_t max;
+} ESP8266_AT_Param;
+
+typedef struct
+{
+    const char *verb;
+    const char *reply;
+    const ESP8266_AT_Param *params;
+    uint16_t timeout;
+    uint8_t verb_len;
+    uint8_t reply_len;
+    uint8_t forms;
+    uint8_t required;
+    uint8_t param_count;
+} ESP8266_AT_Command;
+
+// one argument of a SET form: u for ESP8266_AT_UINT, s for
+// ESP8266_AT_STRING, bytes for ESP8266_AT_IPV4 and ESP8266_AT_MAC
+typedef union
+{
+    uint32_t u;
+    const char *s;
+    const uint8_t *bytes;
+} ESP8266_AT_Arg;
+
+// generated from ESP8266_AT_COMMANDS, indexed by ESP8266_AT_CmdId
+extern const ESP8266_AT_Command ESP8266_AT_Commands[ESP8266_AT_CMD_OTHER];
 
 // basic AT commands
 
@@ -48,13 +215,14 @@ void ESP8266_AT_GMR(UART_HandleTypeDef *uart, uint8_t timeout);
 /*
  * @brief Enters Deep-sleep Mode. ESP8266 will wake up after
  * Deep-sleep for as many milliseconds (ms) as <time> indicates
- * @param <time>: the duration of ESP8266's sleep. Unit: ms
+ * @param <time>: the duration of ESP8266's sleep. Unit: ms. The
+ * longest sleep is ESP8266_AT_GSLP_MAX_MS, about 71 minutes
  * @returns <time>, OK
  * @note A minor adjustment has to be made before the module
  * enter the Deep-sleep mode, i.e., connecting XPD_DCDC to
  * EXT_RSTB via a 0-ohm resistor.
  */
-void ESP8266_AT_GSLP(UART_HandleTypeDef *uart, uint8_t time, uint8_t timeout);
+void ESP8266_AT_GSLP(UART_HandleTypeDef *uart, uint32_t time, uint8_t timeout);
 
 /*
  * @brief AT Commands Echoing, This command ATE is used to trigger
@@ -103,7 +271,7 @@ void ESP8266_AT_UART_CUR_QUERY(UART_HandleTypeDef *uart, uint8_t timeout);
  * 3: enable both RTS and CTS
  * @returns OK
  */
-void ESP8266_AT_UART_CUR_SET(UART_HandleTypeDef *uart, uint8_t baudrate,
+void ESP8266_AT_UART_CUR_SET(UART_HandleTypeDef *uart, uint32_t baudrate,
                              uint8_t databits, uint8_t stopbits,
                              uint8_t parity, uint8_t flow_control,
                              uint8_t timeout);
@@ -173,7 +341,8 @@ void ESP8266_AT_SLEEP_SET(UART_HandleTypeDef *uart, uint8_t sleep_mode,
  * @param <awake_level> OPTIONAL PARAM. true: GPIO is set to high after
  * wake. false: GPIO is set to low after wake
  * @returns OK
- * @note Optional params are nullable
+ * @note Pass ESP8266_AT_NO_GPIO as <awake_GPIO> to leave out both
+ * optional params
  */
 void ESP8266_AT_WAKEUPGPIO(UART_HandleTypeDef *uart, bool enable,
                            uint8_t trigger_gpio, bool trigger_level,
@@ -184,7 +353,7 @@ void ESP8266_AT_WAKEUPGPIO(UART_HandleTypeDef *uart, bool enable,
  * maximum value of ESP8266 RF TX power; it is not precise. The actual
  * value could be smaller than the set value.
  * @param <TX Power>. Tx power :=[0,82]. Tx power is the maximum value
- * of RF TX power.
+ * of RF TX power, in 0.25 dBm steps. Larger values are clamped to 82
  * @returns OK
  */
 void ESP8266_AT_RFPOWER(UART_HandleTypeDef *uart, uint8_t Tx_power, uint8_t timeout);
@@ -203,7 +372,7 @@ void ESP8266_AT_RFVDD_QUERY(UART_HandleTypeDef *uart, uint8_t timeout);
  * @param <VD33>: VD33 := [1900,3300]. power voltage of ESP8266 VDD33
  * @returns OK
  */
-void ESP8266_AT_RFVDD_SET(UART_HandleTypeDef *uart, uint8_t VD33, uint8_t timeout);
+void ESP8266_AT_RFVDD_SET(UART_HandleTypeDef *uart, uint16_t VD33, uint8_t timeout);
 
 /*
  * @brief Execute RF TX Power According to VDD33. Automatically sets
@@ -318,9 +487,64 @@ void ESP8266_AT_SYSMSG_DEF(UART_HandleTypeDef *uart,
                            bool set_quit_message,
                            bool set_establish_message, uint8_t timeout);
 
+/*
+ * @brief Builds a command line from its ESP8266_AT_COMMANDS entry,
+ * checking the form and every argument against the table. No CR/LF
+ * is appended.
+ * @param <form>: ESP8266_AT_EXEC, ESP8266_AT_QUERY or ESP8266_AT_SET
+ * @param <args>: arguments of the SET form, NULL for the others
+ * @param <count>: number of <args>
+ * @returns length written, 0 if the form or an argument is invalid or
+ * the line does not fit in <size>
+ */
+uint16_t ESP8266_AT_Format(char *buf, size_t size, ESP8266_AT_CmdId id, uint8_t form,
+                           const ESP8266_AT_Arg *args, uint8_t count);
+
+/*
+ * @brief Splits the information line of a command's reply into its
+ * fields. Numbers are stored as they are, quoted strings as 0.
+ * @param <line>: response line without CR/LF
+ * @param <values>: receives up to <max> fields
+ * @returns number of fields read, stopping at the first field that is
+ * neither, -1 if <line> does not start with the command's reply prefix
+ */
+int8_t ESP8266_AT_ParseReply(ESP8266_AT_CmdId id, const char *line, int32_t *values, uint8_t max);
+
+/*
+ * @brief Highest standard ESP8266 baud rate the MCU USART can generate
+ * from its current peripheral clock with an error within
+ * ESP8266_AT_BAUD_TOLERANCE_PERMILLE. Call again after every system
+ * clock change.
+ * @returns baud rate, 0 if not even 115200 can be reached
+ */
+uint32_t ESP8266_AT_MaxBaud(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Identifies a command line by its verb, the part before any
+ * '=', '?' or parameter digits
+ * @returns the command's id, ESP8266_AT_CMD_OTHER if not in
+ * ESP8266_AT_COMMANDS
+ */
+ESP8266_AT_CmdId ESP8266_AT_CommandId(const char *cmd);
+
 // Wi-Fi AT Commands
 
-// void ESP8266_AT_CWMODE_CUR(UART_HandleTypeDef *uart, uint8_t timeout);
+/*
+ * @brief Query the Current Wi-Fi Mode
+ * @returns +CWMODE_CUR:<mode>, OK
+ */
+void ESP8266_AT_CWMODE_CUR_QUERY(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Set the Current Wi-Fi Mode; Configuration Not Saved in the
+ * Flash. Skipped when the mode is known to be set already, see
+ * ESP8266_AT_Config.h
+ * @param <mode>: mode := {1,2,3}. 1: Station mode. 2: SoftAP mode.
+ * 3: SoftAP+Station mode
+ * @returns OK
+ */
+void ESP8266_AT_CWMODE_CUR_SET(UART_HandleTypeDef *uart, uint8_t mode, uint8_t timeout);
+
 // void ESP8266_AT_CWMODE_DEF(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CWJAP_CUR(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CWJAP_DEF(UART_HandleTypeDef *uart, uint8_t timeout);
@@ -368,13 +592,54 @@ void ESP8266_AT_SYSMSG_DEF(UART_HandleTypeDef *uart,
 // void ESP8266_AT_CIPCHECKSEQ(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CIPCLOSE(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CIFSR(UART_HandleTypeDef *uart, uint8_t timeout);
-// void ESP8266_AT_CIPMUX(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Query the Connection Mode
+ * @returns +CIPMUX:<mode>, OK
+ */
+void ESP8266_AT_CIPMUX_QUERY(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Enable or Disable Multiple Connections. Can only be changed
+ * while there is no connection. Skipped when the mode is known to be
+ * set already, see ESP8266_AT_Config.h
+ * @param <multiple>: false: single connection. true: up to 5 connections
+ * @returns OK
+ */
+void ESP8266_AT_CIPMUX_SET(UART_HandleTypeDef *uart, bool multiple, uint8_t timeout);
+
 // void ESP8266_AT_CIPSERVER(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CIPSERVERMAXCONN(UART_HandleTypeDef *uart, uint8_t timeout);
-// void ESP8266_AT_CIPMODE(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Query the Transmission Mode
+ * @returns +CIPMODE:<mode>, OK
+ */
+void ESP8266_AT_CIPMODE_QUERY(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Set the Transmission Mode. Skipped when the mode is known to be
+ * set already, see ESP8266_AT_Config.h
+ * @param <passthrough>: false: normal mode. true: UART-WiFi
+ * passthrough mode, only with a single connection
+ * @returns OK
+ */
+void ESP8266_AT_CIPMODE_SET(UART_HandleTypeDef *uart, bool passthrough, uint8_t timeout);
+
 // void ESP8266_AT_SAVETRANSLINK(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CIPSTO(UART_HandleTypeDef *uart, uint8_t timeout);
-// void ESP8266_AT_PING(UART_HandleTypeDef *uart, uint8_t timeout);
+
+/*
+ * @brief Ping Packets. Pings a remote host and reports the round trip
+ * time of the reply.
+ * @param <host>: string; host IP or domain name, without quotes
+ * @returns +<time>, OK
+ * @returns on failure: +timeout, ERROR
+ * @note <time> is in milliseconds. The ping itself can take up to a
+ * few seconds, so use a timeout well above the expected round trip
+ */
+void ESP8266_AT_PING(UART_HandleTypeDef *uart, const char *host, uint8_t timeout);
+
 // void ESP8266_AT_CIUPDATE(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_AT_CIPDINFO(UART_HandleTypeDef *uart, uint8_t timeout);
 // void ESP8266_IPD(UART_HandleTypeDef *uart, uint8_t timeout);
@@ -0,0 +1,249 @@
+/**
+ * ESP8266_AT_Async.h
+ * Non-blocking command engine for the ESP8266 AT driver.
+ * Commands are queued with ESP8266_AT_Async_Submit and sent one at a
+ * time through the double-buffered DMA transmitter in ESP8266_AT_Tx.h;
+ * the engine never waits on the UART. Received bytes are pushed
+ * into a ring buffer from the UART receive interrupt and assembled into
+ * lines by ESP8266_AT_Async_Poll, which must be called regularly from
+ * the main loop. Every callback runs from ESP8266_AT_Async_Poll, never
+ * from interrupt context.
+ *
+ * Commands wait in one FIFO lane per priority. Whenever the link is
+ * between transactions the engine sends from the highest lane holding
+ * a command, so a PING or CIPCLOSE overtakes bulk traffic already
+ * queued; a command in flight is never interrupted. After CIPSEND is
+ * answered the module takes the next bytes as payload, so nothing else
+ * is sent until it reports SEND OK or SEND FAIL.
+ */
+
+#ifndef ESP8266_AT_ASYNC_H
+#define ESP8266_AT_ASYNC_H
+
+#include "ESP8266_AT_Boot.h"
+#include "ESP8266_AT_Config.h"
+#include "ESP8266_AT_Pool.h"
+
+#define ESP8266_AT_ASYNC_QUEUE_LEN 8 // command records in the pool
+#define ESP8266_AT_ASYNC_HIGH_RESERVE 1 // records only ESP8266_AT_PRIO_HIGH may take
+#define ESP8266_AT_ASYNC_PAYLOAD_TIMEOUT 5000 // ms from CIPSEND's OK to SEND OK
+#define ESP8266_AT_ASYNC_RECLOCK_TIMEOUT 1000 // ms for queued bytes to go out
+#define ESP8266_AT_ASYNC_CMD_LEN ESP8266_AT_LINE_MAX
+#define ESP8266_AT_ASYNC_LINE_LEN 128
+#define ESP8266_AT_ASYNC_RX_LEN 256 // must be a power of two
+
+typedef enum
+{
+    ESP8266_AT_PENDING,
+    ESP8266_AT_OK,
+    ESP8266_AT_ERROR,
+    ESP8266_AT_TIMEOUT
+} ESP8266_AT_Result;
+
+typedef enum
+{
+    ESP8266_AT_PRIO_NORMAL,
+    ESP8266_AT_PRIO_HIGH, // link control and keepalives
+    ESP8266_AT_PRIO_COUNT
+} ESP8266_AT_Priority;
+
+// time commands of one priority spent queued before being sent
+typedef struct
+{
+    uint32_t commands;
+    uint32_t total_ms;
+    uint32_t max_ms;
+} ESP8266_AT_WaitStats;
+
+/*
+ * @brief Called for every response line received while the command is
+ * in flight, except the final result code. Lines have CR/LF removed.
+ */
+typedef void (*ESP8266_AT_LineHandler)(const char *line, void *ctx);
+
+/*
+ * @brief Called once when the command completes with its final result
+ */
+typedef void (*ESP8266_AT_DoneHandler)(ESP8266_AT_Result result, void *ctx);
+
+/*
+ * @brief Binds the engine to a UART and starts interrupt reception.
+ * The USART interrupt must be enabled in the NVIC, and so must the DMA
+ * stream linked as the UART's hdmatx, if any.
+ * @returns false if ESP8266_AT_Keyword_Init reports a collision; the
+ * engine does not receive then
+ */
+bool ESP8266_AT_Async_Init(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Queues a command for transmission. CR/LF is appended.
+ * @param <cmd>: command string, e.g. "AT+SYSRAM?". Copied into the queue
+ * @param <timeout>: time in ms allowed between sending the command and
+ * its final result code
+ * @param <on_line>: nullable. Receives the intermediate response lines
+ * @param <on_done>: nullable. Receives the final result
+ * @param <ctx>: passed back to both handlers
+ * @returns true if queued, false if the queue is full or cmd is too long
+ */
+bool ESP8266_AT_Async_Submit(const char *cmd, uint32_t timeout,
+                             ESP8266_AT_LineHandler on_line,
+                             ESP8266_AT_DoneHandler on_done, void *ctx);
+
+/*
+ * @brief Queues a command from the ESP8266_AT_COMMANDS table. The line
+ * is formatted straight into the queue and checked against the table,
+ * and the command needs no lookup when it is sent. A SET of a setting
+ * the config cache knows to be current, or a query of a known setting,
+ * completes with ESP8266_AT_OK without being sent; a query's on_line
+ * then gets the reply line built from the cache.
+ * @param <form>: ESP8266_AT_EXEC, ESP8266_AT_QUERY or ESP8266_AT_SET
+ * @param <args>: arguments of the SET form, NULL for the others
+ * @param <count>: number of <args>
+ * @param <timeout>: as for ESP8266_AT_Async_Submit, 0 for the
+ * command's default from the table
+ * @returns true if queued, false if the queue is full or the command
+ * does not pass ESP8266_AT_Format
+ */
+bool ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CmdId id, uint8_t form,
+                                const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                ESP8266_AT_LineHandler on_line,
+                                ESP8266_AT_DoneHandler on_done, void *ctx);
+
+/*
+ * @brief ESP8266_AT_Async_SubmitCmd with a priority. Commands submitted
+ * without one are ESP8266_AT_PRIO_NORMAL. The last
+ * ESP8266_AT_ASYNC_HIGH_RESERVE records are kept for higher priorities,
+ * so a queue full of bulk traffic cannot lock them out
+ */
+bool ESP8266_AT_Async_SubmitPrio(ESP8266_AT_Priority prio, ESP8266_AT_CmdId id, uint8_t form,
+                                 const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                 ESP8266_AT_LineHandler on_line,
+                                 ESP8266_AT_DoneHandler on_done, void *ctx);
+
+/*
+ * @brief Drives the engine: assembles and dispatches received lines,
+ * expires timed out commands and starts the next queued command.
+ * Call from the main loop.
+ */
+void ESP8266_AT_Async_Poll(void);
+
+/*
+ * @returns true when no command is queued or in flight
+ */
+bool ESP8266_AT_Async_Idle(void);
+
+/*
+ * @returns true when ESP8266_AT_Async_Poll has something to do right
+ * now: received bytes to assemble or a command ready to send
+ */
+bool ESP8266_AT_Async_WorkPending(void);
+
+/*
+ * @returns true when nothing is in flight, being transmitted or waiting
+ * in the RX ring, and no command can start. Only then may the MCU stop
+ * its clocks
+ */
+bool ESP8266_AT_Async_Quiet(void);
+
+/*
+ * @returns true from the '>' prompt that follows CIPSEND's OK until the
+ * module reports on the payload: write it with ESP8266_AT_Async_Write
+ */
+bool ESP8266_AT_Async_PayloadReady(void);
+
+/*
+ * @returns the outcome of the last CIPSEND payload: ESP8266_AT_PENDING
+ * from CIPSEND's OK until the module reports on it, then ESP8266_AT_OK
+ * on SEND OK, ESP8266_AT_ERROR on SEND FAIL, a restart or a CIPSEND
+ * that did not complete OK, and ESP8266_AT_TIMEOUT after
+ * ESP8266_AT_ASYNC_PAYLOAD_TIMEOUT
+ */
+ESP8266_AT_Result ESP8266_AT_Async_PayloadResult(void);
+
+/*
+ * @brief Queues raw bytes for transmission, e.g. a CIPSEND payload once
+ * the module has answered with its '>' prompt. Bytes go out behind any
+ * command line already handed to the transmitter and while the next
+ * command is being formatted.
+ * @returns number of bytes queued, less than <len> when the transmit
+ * buffer is full. Queue the rest from a later poll
+ */
+uint16_t ESP8266_AT_Async_Write(const void *data, uint16_t len);
+
+/*
+ * @brief Usage of the command record pool; its high-water mark tells
+ * how close ESP8266_AT_ASYNC_QUEUE_LEN came to being exhausted
+ */
+void ESP8266_AT_Async_SlotStats(ESP8266_AT_PoolStats *stats);
+
+/*
+ * @brief Queue wait of the commands of <prio> sent or answered from the
+ * config cache so far; max_ms bounds the latency of that priority
+ */
+void ESP8266_AT_Async_WaitStats(ESP8266_AT_Priority prio, ESP8266_AT_WaitStats *stats);
+
+/*
+ * @brief Holds queued commands back while the module cannot accept
+ * them, e.g. in Light-sleep. Reception keeps running.
+ * @param <hold>: true: stop starting new commands. false: resume
+ */
+void ESP8266_AT_Async_Hold(bool hold);
+
+/*
+ * @brief Forgets the module state as it is reset from outside, e.g.
+ * through its reset pin. Drops received bytes, forgets the config
+ * cache, does ESP8266_AT_Async_Abort and holds new commands until the
+ * module reports ready, see ESP8266_AT_Boot.h. Restarts the engine
+ * sees coming, after AT+RST, AT+RESTORE and AT+GSLP, need no call
+ */
+void ESP8266_AT_Async_Reset(void);
+
+/*
+ * @brief Fails every queued command with ESP8266_AT_ERROR and drops
+ * any payload being transmitted. The module state is left as it is
+ */
+void ESP8266_AT_Async_Abort(void);
+
+/*
+ * @brief Reprograms the USART baud rate generator after a system clock
+ * change, or after Init.BaudRate was changed to follow AT+UART_CUR.
+ * Waits up to ESP8266_AT_ASYNC_RECLOCK_TIMEOUT for a transmission in
+ * progress to finish, then drops what is left.
+ * @returns false if bytes were dropped
+ */
+bool ESP8266_AT_Async_Reclock(void);
+
+/*
+ * @brief Pushes bytes into the receive path as if they came from the
+ * UART. Call ESP8266_AT_Async_Poll to parse them.
+ * @returns number of bytes accepted before the RX ring filled up
+ */
+uint16_t ESP8266_AT_Async_Feed(const uint8_t *data, uint16_t len);
+
+/*
+ * @brief Fast path for received bytes. Call first thing in the USART
+ * interrupt handler: it moves a received byte straight from the data
+ * register into the RX ring while interrupt reception is armed,
+ * without going through HAL_UART_IRQHandler
+ * @returns true if nothing else is pending and HAL_UART_IRQHandler
+ * can be skipped
+ */
+bool ESP8266_AT_Async_IRQHandler(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Forward HAL_UART_TxCpltCallback here
+ */
+void ESP8266_AT_Async_TxCpltCallback(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Forward HAL_UART_RxCpltCallback here
+ */
+void ESP8266_AT_Async_RxCpltCallback(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Forward HAL_UART_ErrorCallback here. Restarts reception after
+ * overrun, noise or framing errors.
+ */
+void ESP8266_AT_Async_ErrorCallback(UART_HandleTypeDef *uart);
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * ESP8266_AT_Boot.h
+ * Boot sequence tracking. After a reset the ESP8266 ROM bootloader
+ * prints its banner at 74880 baud, which arrives as garbage at any
+ * other rate, and the AT firmware then starts up and prints "ready".
+ * Instead of waiting a fixed delay, the async engine holds queued
+ * commands from ESP8266_AT_Boot_Start until the banner arrives and
+ * sends them the moment it does.
+ *
+ * Lines received while booting are dropped, so the ROM output never
+ * reaches a command or URC handler, and line assembly is back in step
+ * at the first CR/LF after it. A line that ends in "ready" ends the
+ * boot even with garbage in front of it.
+ *
+ * Each boot is timed in phases: reset to the first received byte (ROM
+ * output), to the first clean line (firmware output) and to "ready".
+ */
+
+#ifndef ESP8266_AT_BOOT_H
+#define ESP8266_AT_BOOT_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_AT_BOOT_TIMEOUT_MS 3000 // reset to "ready" before giving up
+
+typedef enum
+{
+    ESP8266_AT_BOOT_DONE,     // "ready" received, or no boot was started
+    ESP8266_AT_BOOT_RESET,    // nothing received since the reset
+    ESP8266_AT_BOOT_ROM,      // receiving the ROM bootloader output
+    ESP8266_AT_BOOT_FIRMWARE, // receiving clean lines from the firmware
+    ESP8266_AT_BOOT_TIMEOUT   // no "ready" in time; commands are let through
+} ESP8266_AT_BootPhase;
+
+typedef struct
+{
+    uint32_t boots;
+    uint32_t timeouts;
+    uint32_t unexpected;    // "ready" without a boot started: the module restarted on its own
+    uint32_t dropped_lines; // received while booting
+    // last boot, in ms after it was due to start. 0 for phases not seen
+    uint32_t rom_ms;
+    uint32_t firmware_ms;
+    uint32_t ready_ms;
+} ESP8266_AT_BootStats;
+
+/*
+ * @brief Starts tracking a boot. Call as the module is reset or powered
+ * up; the async engine calls it itself after AT+RST and AT+RESTORE.
+ */
+void ESP8266_AT_Boot_Start(void);
+
+/*
+ * @brief Starts tracking a boot due in <delay_ms>, e.g. the wake-up at
+ * the end of AT+GSLP, which the async engine tracks itself. Commands
+ * are held from now on, and the timeout runs from the end of the delay
+ */
+void ESP8266_AT_Boot_Expect(uint32_t delay_ms);
+
+/*
+ * @brief Call whenever bytes have been received. Marks the end of the
+ * reset phase.
+ */
+void ESP8266_AT_Boot_Received(void);
+
+/*
+ * @brief Call with every assembled line, CR/LF removed
+ * @param <overflow>: the line was too long and has been cut short
+ * @returns true if the line is boot output and must be dropped
+ */
+bool ESP8266_AT_Boot_Line(const char *line, uint16_t len, bool overflow);
+
+/*
+ * @brief Ends a boot that has run past ESP8266_AT_BOOT_TIMEOUT_MS
+ * @returns true when the module can take commands
+ */
+bool ESP8266_AT_Boot_Ready(void);
+
+ESP8266_AT_BootPhase ESP8266_AT_Boot_Phase(void);
+
+void ESP8266_AT_Boot_GetStats(ESP8266_AT_BootStats *stats);
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * ESP8266_AT_Capture.h
+ * Records the exact byte stream received from the ESP8266, with the
+ * time between bytes, and replays such captures through the async
+ * engine's parser. Replay runs either at the captured pace or flat out,
+ * giving reproducible throughput and latency figures from real traffic.
+ * Recording is compiled out unless ESP8266_AT_CAPTURE is defined;
+ * replay is always available.
+ * On target, time is taken from DWT->CYCCNT. Elsewhere it is
+ * CLOCK_MONOTONIC nanoseconds, so captures replay on the host too.
+ * Either wraps within seconds, so gaps of ESP8266_CAPTURE_LONG_GAP_MS
+ * or more are recorded from HAL_GetTick instead, at 1 ms resolution,
+ * and saturate at UINT32_MAX us.
+ *
+ * Capture format, version 1:
+ *   'C', ESP8266_CAPTURE_VERSION, 0, 0, <baud rate: u32 LE>,
+ *   then per received byte: <delay since previous byte in us: unsigned
+ *   LEB128 varint>, <byte>
+ */
+
+#ifndef ESP8266_AT_CAPTURE_H
+#define ESP8266_AT_CAPTURE_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_CAPTURE_LEN 4096 // bytes of capture buffer
+#define ESP8266_CAPTURE_VERSION 1
+#define ESP8266_CAPTURE_HEADER_LEN 8
+#define ESP8266_CAPTURE_LONG_GAP_MS 1000 // longer gaps are timed on HAL_GetTick
+
+#if defined(__ARM_ARCH)
+#define ESP8266_CAPTURE_NOW() (DWT->CYCCNT)
+#define ESP8266_CAPTURE_TICKS_PER_US() (SystemCoreClock / 1000000)
+#else
+#include <time.h>
+static inline uint32_t ESP8266_Capture_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#define ESP8266_CAPTURE_NOW() ESP8266_Capture_Ns()
+#define ESP8266_CAPTURE_TICKS_PER_US() 1000U
+#endif
+
+typedef struct
+{
+    uint32_t bytes;   // payload bytes replayed
+    uint32_t cycles;  // ESP8266_CAPTURE_NOW ticks spent, waits included
+    uint32_t dropped; // bytes the RX ring could not take
+} ESP8266_ReplayStats;
+
+#ifdef ESP8266_AT_CAPTURE
+
+#define ESP8266_CAPTURE_BYTE(byte) ESP8266_Capture_Byte(byte)
+
+/*
+ * @brief Clears the buffer and starts recording
+ * @param <baud>: UART baud rate, stored in the header
+ */
+void ESP8266_Capture_Start(uint32_t baud);
+
+void ESP8266_Capture_Stop(void);
+
+/*
+ * @brief Appends one received byte. Called from the RX interrupt;
+ * recording stops by itself when the buffer is full
+ */
+void ESP8266_Capture_Byte(uint8_t byte);
+
+/*
+ * @returns the capture, header included
+ */
+const uint8_t *ESP8266_Capture_Data(size_t *len);
+
+#else
+
+#define ESP8266_CAPTURE_BYTE(byte) ((void)0)
+
+#endif
+
+/*
+ * @brief Plays a capture into the RX path, polling the engine as it
+ * goes. The engine must have been initialised.
+ * @param <real_time>: true: keep the captured inter-byte timing.
+ * false: as fast as the parser goes
+ * @returns false if the capture header is not recognised
+ */
+bool ESP8266_Capture_Replay(const uint8_t *capture, size_t len, bool real_time,
+                            ESP8266_ReplayStats *stats);
+
+#endif
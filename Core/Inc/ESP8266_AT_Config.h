@@ -0,0 +1,104 @@
+/**
+ * ESP8266_AT_Config.h
+ * Shadow copy of the module settings listed in ESP8266_AT_CONFIG.
+ * Every setting starts out unknown. It becomes known when a SET of it
+ * or a query of it completes with OK, and unknown again when a SET
+ * fails or the setting is changed behind the cache's back: by a raw
+ * command line, AT+RST, AT+RESTORE, AT+GSLP, the matching _DEF command
+ * or a "ready" banner from a module that restarted on its own.
+ *
+ * While a setting is known, a SET to the value it already has and a
+ * query of it are answered from here without touching the UART. The
+ * async engine consults the cache when a command reaches the head of
+ * the queue, so commands queued ahead of it are accounted for.
+ */
+
+#ifndef ESP8266_AT_CONFIG_H
+#define ESP8266_AT_CONFIG_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_AT_CONFIG_VALUES 5 // most parameters of a cached command
+
+// cached commands: every parameter must be an ESP8266_AT_UINT
+#define ESP8266_AT_CONFIG(C) \
+    C(ATE)                   \
+    C(UART_CUR)              \
+    C(SLEEP)                 \
+    C(SYSMSG_CUR)            \
+    C(CWMODE_CUR)            \
+    C(CIPMUX)                \
+    C(CIPMODE)
+
+typedef struct
+{
+    uint32_t hits;          // commands answered without being sent
+    uint32_t invalidations; // times the whole cache was dropped
+} ESP8266_AT_ConfigStats;
+
+/*
+ * @brief Forgets every setting, e.g. after the module restarted
+ */
+void ESP8266_AT_Config_Invalidate(void);
+
+/*
+ * @returns true if <id> is one of ESP8266_AT_CONFIG
+ */
+bool ESP8266_AT_Config_Tracked(ESP8266_AT_CmdId id);
+
+/*
+ * @brief Checks whether a command can be answered locally: a SET whose
+ * arguments all match the known setting, or a query of a known setting.
+ * Counts a hit when it can.
+ * @param <form>: ESP8266_AT_QUERY or ESP8266_AT_SET
+ * @returns true if the command need not be sent
+ */
+bool ESP8266_AT_Config_Current(ESP8266_AT_CmdId id, uint8_t form,
+                               const ESP8266_AT_Arg *args, uint8_t count);
+
+/*
+ * @brief Reads a known setting
+ * @param <values>: receives up to <max> parameters
+ * @returns number of parameters, -1 if the setting is unknown
+ */
+int8_t ESP8266_AT_Config_Get(ESP8266_AT_CmdId id, int32_t *values, uint8_t max);
+
+/*
+ * @brief Builds the reply line the module would give to a query of a
+ * known setting, e.g. +SLEEP:2. The line is null-terminated.
+ * @returns length written, 0 if the setting is unknown or has no query
+ * reply, or the line does not fit in <size>
+ */
+uint16_t ESP8266_AT_Config_Reply(ESP8266_AT_CmdId id, char *buf, size_t size);
+
+/*
+ * @brief Call when a command line goes to the module. Drops what the
+ * command may change until ESP8266_AT_Config_Done confirms it; a line
+ * whose verb is not in the table drops everything.
+ * @param <form>: the form the line was sent in
+ */
+void ESP8266_AT_Config_Sent(ESP8266_AT_CmdId id, uint8_t form);
+
+/*
+ * @brief ESP8266_AT_Config_Sent for a raw command line: its form is
+ * read from the line. A query, or a verb outside the table known to
+ * change no setting, drops nothing
+ * @param <line>: the command line, CR/LF optional
+ */
+void ESP8266_AT_Config_SentLine(const char *line);
+
+/*
+ * @brief Call with every information line of a command in flight
+ */
+void ESP8266_AT_Config_Line(ESP8266_AT_CmdId id, const char *line);
+
+/*
+ * @brief Call when a sent command completes. A SET stores its
+ * arguments and a query the values of its reply line if <ok>.
+ */
+void ESP8266_AT_Config_Done(ESP8266_AT_CmdId id, uint8_t form,
+                            const ESP8266_AT_Arg *args, uint8_t count, bool ok);
+
+void ESP8266_AT_Config_GetStats(ESP8266_AT_ConfigStats *stats);
+
+#endif
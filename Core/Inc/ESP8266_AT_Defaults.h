@@ -0,0 +1,77 @@
+/**
+ * ESP8266_AT_Defaults.h
+ * Skip-if-unchanged provisioning of the settings the module keeps in
+ * its own flash (the _DEF commands). The desired settings are hashed,
+ * and the hash of the last set the module accepted is kept in a
+ * reserved sector of the MCU flash. At boot, ESP8266_AT_Defaults_Apply
+ * compares the two and only sends the _DEF commands when they differ,
+ * which saves boot time and wear on the module's flash.
+ *
+ * Hashes are appended to the sector as {hash, ~hash} records, and the
+ * last record before the erased space is the current one. Finding it is
+ * a binary search, and the sector is only erased once it is full.
+ * A record torn by a power failure does not verify and counts as no hash.
+ * The sector is excluded from the FLASH region in STM32F446RETX_FLASH.ld.
+ */
+
+#ifndef ESP8266_AT_DEFAULTS_H
+#define ESP8266_AT_DEFAULTS_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_AT_DEFAULTS_SECTOR FLASH_SECTOR_7
+#define ESP8266_AT_DEFAULTS_ADDR 0x08060000U
+#define ESP8266_AT_DEFAULTS_SIZE 0x20000U
+#define ESP8266_AT_DEFAULTS_VERSION 1 // change when the commands sent change
+
+typedef struct
+{
+    uint8_t wifi_mode;    // AT+CWMODE_DEF: 1 station, 2 SoftAP, 3 both
+    uint32_t baudrate;    // AT+UART_DEF, sent last; see ESP8266_AT_Async_Reclock
+    uint8_t databits;
+    uint8_t stopbits;
+    uint8_t parity;
+    uint8_t flow_control;
+    uint8_t sysmsg;       // AT+SYSMSG_DEF: bit 0 +QUITT, bit 1 +LINK_CONN
+    bool dhcp;            // station DHCP, or the static address below
+    uint8_t ip[4];        // AT+CIPSTA_DEF when dhcp is false
+    uint8_t gateway[4];
+    uint8_t netmask[4];
+    bool auto_connect;    // AT+CWAUTOCONN
+    const char *ssid;     // AT+CWJAP_DEF, NULL to leave the stored AP alone
+    const char *password;
+} ESP8266_AT_Defaults;
+
+/*
+ * @returns fingerprint of <defaults>, never 0
+ */
+uint32_t ESP8266_AT_Defaults_Hash(const ESP8266_AT_Defaults *defaults);
+
+/*
+ * @returns fingerprint of the settings last applied, 0 if none is stored
+ */
+uint32_t ESP8266_AT_Defaults_Stored(void);
+
+/*
+ * @brief Queues the _DEF commands for <defaults> unless the stored
+ * fingerprint matches. The fingerprint is stored once every command has
+ * completed with OK.
+ * @param <defaults>: strings are copied into the queue, so they need not
+ * outlive the call
+ * @param <on_done>: nullable. Called with the overall result once the
+ * last command completes. Not called when nothing is queued
+ * @returns ESP8266_AT_OK if the settings are unchanged and nothing was
+ * queued, ESP8266_AT_PENDING if commands were queued, ESP8266_AT_ERROR
+ * if none could be or an earlier Apply is still running
+ */
+ESP8266_AT_Result ESP8266_AT_Defaults_Apply(const ESP8266_AT_Defaults *defaults,
+                                            ESP8266_AT_DoneHandler on_done, void *ctx);
+
+/*
+ * @brief Stores "no fingerprint", so the next Apply sends everything.
+ * Called by ESP8266_AT_Config_Sent, so for blocking and async alike,
+ * when AT+RESTORE wipes the module's flash.
+ */
+void ESP8266_AT_Defaults_Forget(void);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * ESP8266_AT_Flash.h
+ * Flash access for persistent driver state, behind a table of
+ * operations so the code using it can run on the host against a
+ * simulated flash array. Storage is split into two equal banks that
+ * are read through memory and erased as a whole. Erasing sets every
+ * byte to 0xFF and programming can only clear bits, as on the STM32.
+ */
+
+#ifndef ESP8266_AT_FLASH_H
+#define ESP8266_AT_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct
+{
+    uint32_t size;          // bytes per bank
+    const uint8_t *base[2]; // where each bank reads
+    /*
+     * @brief Erases a whole bank
+     */
+    bool (*erase)(uint8_t bank);
+    /*
+     * @brief Programs <len> bytes at <offset> into a bank. <offset> and
+     * <len> are multiples of 4 and the target bytes are erased
+     */
+    bool (*program)(uint8_t bank, uint32_t offset, const void *data, uint32_t len);
+} ESP8266_AT_FlashOps;
+
+#ifdef USE_HAL_DRIVER
+// sectors 5 and 6 of the STM32F446, excluded from the FLASH region in
+// STM32F446RETX_FLASH.ld
+extern const ESP8266_AT_FlashOps ESP8266_AT_FlashStm32;
+
+/*
+ * @brief Flushes the ART data cache, which may still hold what a word
+ * read before it was programmed or erased. Call after every write to
+ * flash that is then read through memory
+ */
+void ESP8266_AT_Flash_FlushDataCache(void);
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * ESP8266_AT_Gpio.h
+ * Uses the ESP8266's spare pins as a slow GPIO expander. A shadow copy
+ * of pin mode, direction and level is kept on the MCU. Setters only
+ * touch the shadow; ESP8266_Gpio_Process sends the pins whose shadow
+ * differs from what the module last acknowledged, back to back through
+ * the async engine. Writes that cancel out before the flush cost no
+ * command at all. Reads are answered from a cache for up to
+ * staleness_ms before AT+SYSGPIOREAD is sent again.
+ */
+
+#ifndef ESP8266_AT_GPIO_H
+#define ESP8266_AT_GPIO_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_GPIO_PINS 16
+
+/*
+ * @param <staleness_ms>: age up to which a read level is served from
+ * the cache
+ */
+void ESP8266_Gpio_Init(uint32_t staleness_ms);
+
+/*
+ * @brief Selects the pin's IO mode (AT+SYSIOSETCFG), e.g. its GPIO
+ * function. See the ESP8266 Pin List for the mode numbers
+ */
+void ESP8266_Gpio_Configure(uint8_t pin, uint8_t mode, bool pull_up);
+
+/*
+ * @param <output>: true: output. false: input
+ */
+void ESP8266_Gpio_SetDir(uint8_t pin, bool output);
+
+void ESP8266_Gpio_Write(uint8_t pin, bool level);
+
+/*
+ * @brief Reads a pin level.
+ * @param <level>: receives the level when the call returns true
+ * @returns true if a level no older than staleness_ms is known. false
+ * otherwise; a read is then queued and a later call returns its result
+ */
+bool ESP8266_Gpio_Read(uint8_t pin, bool *level);
+
+/*
+ * @brief Sends every pending change that fits in the engine queue
+ */
+void ESP8266_Gpio_Process(void);
+
+/*
+ * @brief Marks every pin the application has set as unknown on the
+ * module, so ESP8266_Gpio_Process sends them all again. The async engine
+ * calls it when the module restarts with its pins at their defaults
+ */
+void ESP8266_Gpio_Invalidate(void);
+
+/*
+ * @returns true when all changes have been acknowledged by the module
+ */
+bool ESP8266_Gpio_Synced(void);
+
+#endif
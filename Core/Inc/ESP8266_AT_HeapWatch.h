@@ -0,0 +1,78 @@
+/**
+ * ESP8266_AT_HeapWatch.h
+ * Watchdog for the ESP8266's own heap. Samples AT+SYSRAM? through the
+ * async engine, slowly while memory is plentiful and faster as it runs
+ * low, and applies back-pressure before the module runs out and resets:
+ * - below warn_bytes: new links are refused and sends are delayed
+ * - below critical_bytes: the SSL buffer is shrunk for new SSL links
+ *   and sends are delayed further
+ * The application asks ESP8266_HeapWatch_AllowNewLink before CIPSTART
+ * and waits ESP8266_HeapWatch_SendDelay before every CIPSEND.
+ * Call ESP8266_HeapWatch_Process from the main loop.
+ */
+
+#ifndef ESP8266_AT_HEAPWATCH_H
+#define ESP8266_AT_HEAPWATCH_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_HEAPWATCH_SSL_SMALL 2048
+#define ESP8266_HEAPWATCH_SSL_DEFAULT 4096
+
+typedef enum
+{
+    ESP8266_HEAP_OK,
+    ESP8266_HEAP_WARN,
+    ESP8266_HEAP_CRITICAL
+} ESP8266_HeapLevel;
+
+typedef struct
+{
+    uint32_t warn_bytes;
+    uint32_t critical_bytes;
+    uint32_t slow_period_ms;   // sampling period while level is OK
+    uint32_t fast_period_ms;   // sampling period while WARN or CRITICAL
+    uint32_t warn_delay_ms;    // send delay while WARN
+    uint32_t critical_delay_ms;
+} ESP8266_HeapWatchConfig;
+
+typedef struct
+{
+    uint32_t free_bytes;   // last sample, 0 before the first one
+    uint32_t low_water;    // lowest sample since Init
+    uint32_t samples;
+    uint32_t warn_events;  // transitions out of ESP8266_HEAP_OK
+    uint32_t critical_events;
+    uint32_t links_refused;
+    ESP8266_HeapLevel level;
+} ESP8266_HeapStats;
+
+void ESP8266_HeapWatch_Init(const ESP8266_HeapWatchConfig *config);
+
+/*
+ * @brief Samples free RAM when the current period has elapsed
+ */
+void ESP8266_HeapWatch_Process(void);
+
+/*
+ * @returns false while free RAM is below warn_bytes. Every refusal is
+ * counted in links_refused
+ */
+bool ESP8266_HeapWatch_AllowNewLink(void);
+
+/*
+ * @returns time in ms to hold off the next send, 0 when not throttled
+ */
+uint32_t ESP8266_HeapWatch_SendDelay(void);
+
+/*
+ * @brief Forgets that the SSL buffer was shrunk. The async engine calls
+ * it when the module restarts with the default AT+CIPSSLSIZE
+ */
+void ESP8266_HeapWatch_Invalidate(void);
+
+ESP8266_HeapLevel ESP8266_HeapWatch_Level(void);
+
+void ESP8266_HeapWatch_GetStats(ESP8266_HeapStats *stats);
+
+#endif
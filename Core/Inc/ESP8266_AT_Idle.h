@@ -0,0 +1,54 @@
+/**
+ * ESP8266_AT_Idle.h
+ * Low-power idle for the host MCU while it waits on the ESP8266.
+ * Call ESP8266_Idle_Enter at the end of every main loop pass. It
+ * returns straight away when the async engine has work; otherwise the
+ * MCU sleeps until the next interrupt (UART, SysTick, ...).
+ *
+ * Sleep mode keeps SysTick running so command timeouts stay exact.
+ * Stop mode suspends it with HAL_SuspendTick. The time spent stopped is
+ * measured on the RTC, which keeps running, and added to HAL_GetTick on
+ * wake-up. ESP8266_Idle_Init starts the RTC on the LSI unless the
+ * application already runs it (in 24-hour format); the LSI is only good
+ * to a few percent, so prefer an RTC on the LSE. Without the RTC, Stop
+ * is never used, nor once the RTC has failed to resynchronise after it.
+ * Those Stop periods are not added to the tick.
+ * Stop is left on a falling edge of the USART RX pin only, so nothing
+ * wakes the MCU at a deadline: allow Stop only when no timeout or sleep
+ * schedule is due. The byte that wakes the MCU is lost.
+ */
+
+#ifndef ESP8266_AT_IDLE_H
+#define ESP8266_AT_IDLE_H
+
+#include "ESP8266_AT_Async.h"
+
+typedef struct
+{
+    uint32_t sleep_entries;
+    uint32_t stop_entries;
+    uint16_t asleep_permille;  // share of run time spent in Sleep or Stop mode
+    uint16_t stopped_permille; // share of run time spent in Stop mode
+} ESP8266_IdleStats;
+
+/*
+ * @brief Sets up the idle handler.
+ * @param <rx_port>, <rx_pin>: USART RX pin, armed as wake-up event
+ * source in Stop mode
+ * @param <restore_clock>: nullable. Reconfigures the system clock after
+ * Stop, which always resumes on the HSI. Usually SystemClock_Config
+ */
+void ESP8266_Idle_Init(GPIO_TypeDef *rx_port, uint16_t rx_pin, void (*restore_clock)(void));
+
+/*
+ * @brief Sleeps the MCU until the next interrupt if the driver is idle.
+ * @param <allow_stop>: true: use Stop mode when the engine is quiet
+ */
+void ESP8266_Idle_Enter(bool allow_stop);
+
+/*
+ * @brief Reports sleep statistics since the last call and restarts them
+ */
+void ESP8266_Idle_GetStats(ESP8266_IdleStats *stats);
+
+#endif
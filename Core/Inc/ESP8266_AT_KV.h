@@ -0,0 +1,71 @@
+/**
+ * ESP8266_AT_KV.h
+ * Small key-value store for persistent driver state: Wi-Fi credentials,
+ * the last BSSID and channel, DNS results, the negotiated baud rate,
+ * counters. Keys are small integers below ESP8266_AT_KV_KEYS, so a RAM
+ * index gives every lookup in O(1).
+ *
+ * The store is a log over one of two flash banks. A write appends a new
+ * record and leaves the old one behind. When the bank is full, the live
+ * records are copied to the other bank, which becomes the active one.
+ * The banks take turns, so both wear evenly, and each is erased once per
+ * bank's worth of writes.
+ *
+ * Commits survive power failure at any point. A record counts once its
+ * trailing checksum word is written, and a copied bank counts once its
+ * header is written. Until then the previous state stays current.
+ *
+ * Flash access goes through ESP8266_AT_FlashOps, so the store runs on
+ * the host against a simulated flash array.
+ */
+
+#ifndef ESP8266_AT_KV_H
+#define ESP8266_AT_KV_H
+
+#include "ESP8266_AT_Flash.h"
+
+#define ESP8266_AT_KV_KEYS 32
+#define ESP8266_AT_KV_VALUE_MAX 128
+
+typedef struct
+{
+    uint32_t used;        // bytes of the active bank taken by the log
+    uint32_t live;        // bytes of it holding current values
+    uint32_t size;        // bytes per bank
+    uint32_t sequence;    // times the log moved between banks
+    uint32_t torn;        // records found incomplete at mount
+    uint8_t bank;         // active bank
+} ESP8266_AT_KVStats;
+
+/*
+ * @brief Mounts the store, rebuilding the index from the log. Formats
+ * the flash when no valid bank is found.
+ * @returns false if the flash cannot be written
+ */
+bool ESP8266_AT_KV_Init(const ESP8266_AT_FlashOps *flash);
+
+/*
+ * @brief Copies the value of <key> into <buf>
+ * @returns length of the value, which may exceed <size>; -1 if unset
+ */
+int16_t ESP8266_AT_KV_Get(uint16_t key, void *buf, uint16_t size);
+
+/*
+ * @brief Stores a value. Nothing is written if it is unchanged
+ * @param <len>: 1 to ESP8266_AT_KV_VALUE_MAX
+ * @returns false if <key> or <len> is out of range or the write failed
+ * @note when the bank is full this first moves the log, erasing the other
+ * bank. On the STM32 that stalls code running from flash, interrupts
+ * included, for 1-2 s
+ */
+bool ESP8266_AT_KV_Set(uint16_t key, const void *data, uint16_t len);
+
+/*
+ * @brief Removes a value
+ * @returns false if the write failed
+ */
+bool ESP8266_AT_KV_Delete(uint16_t key);
+
+void ESP8266_AT_KV_GetStats(ESP8266_AT_KVStats *stats);
+
+#endif
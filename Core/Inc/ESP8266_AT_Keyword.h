@@ -0,0 +1,96 @@
+/**
+ * ESP8266_AT_Keyword.h
+ * Classifies received lines by their leading keyword: result codes,
+ * URCs and the information lines of replies. Keywords ending in ':',
+ * ',' or ' ' match as prefixes, the others only the whole line. A line
+ * starting with a link id, "0,CONNECT", is matched after the id.
+ *
+ * ESP8266_AT_Keyword_Match hashes the line in a single pass and probes
+ * a slot table wherever a keyword could end, i.e. at each ':', ',' or
+ * ' ' and at the end of the line; a hit is confirmed with one memcmp.
+ * The table has one keyword per slot, which ESP8266_AT_Keyword_Init
+ * checks when it fills it.
+ */
+
+#ifndef ESP8266_AT_KEYWORD_H
+#define ESP8266_AT_KEYWORD_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_AT_KEYWORD_SLOT_BITS 7
+// multiplier spreading the keyword hashes over the slots; search for a
+// new one when ESP8266_AT_Keyword_Init reports a collision
+#define ESP8266_AT_KEYWORD_SEED 0x9E379739U
+
+#define ESP8266_AT_KEYWORDS(K)                      \
+    K(OK, "OK")                                     \
+    K(ERROR, "ERROR")                               \
+    K(FAIL, "FAIL")                                 \
+    K(SEND_OK, "SEND OK")                           \
+    K(SEND_FAIL, "SEND FAIL")                       \
+    K(BUSY_P, "busy p...")                          \
+    K(BUSY_S, "busy s...")                          \
+    K(READY, "ready")                               \
+    K(NO_CHANGE, "no change")                       \
+    K(ALREADY_CONNECTED, "ALREADY CONNECTED")       \
+    K(WIFI_CONNECTED, "WIFI CONNECTED")             \
+    K(WIFI_GOT_IP, "WIFI GOT IP")                   \
+    K(WIFI_DISCONNECT, "WIFI DISCONNECT")           \
+    K(LINK_CONNECT, "CONNECT")                      \
+    K(LINK_CONNECT_FAIL, "CONNECT FAIL")            \
+    K(LINK_CLOSED, "CLOSED")                        \
+    K(RECV, "Recv ")                                \
+    K(IPD, "+IPD,")                                 \
+    K(CIPRECVDATA, "+CIPRECVDATA,")                 \
+    K(LINK_CONN, "+LINK_CONN:")                     \
+    K(QUITT, "+QUITT")                              \
+    K(STA_CONNECTED, "+STA_CONNECTED:")             \
+    K(STA_DISCONNECTED, "+STA_DISCONNECTED:")       \
+    K(DIST_STA_IP, "+DIST_STA_IP:")                 \
+    K(STATUS, "STATUS:")                            \
+    K(CIPSTATUS, "+CIPSTATUS:")                     \
+    K(CWLAP, "+CWLAP:")                             \
+    K(CWJAP, "+CWJAP:")                             \
+    K(CWJAP_CUR, "+CWJAP_CUR:")                     \
+    K(CIFSR, "+CIFSR:")                             \
+    K(CIPSTA_CUR, "+CIPSTA_CUR:")                   \
+    K(CIPDOMAIN, "+CIPDOMAIN:")                     \
+    K(CIPSNTPTIME, "+CIPSNTPTIME:")                 \
+    K(UART_CUR, "+UART_CUR:")                       \
+    K(UART_DEF, "+UART_DEF:")                       \
+    K(SLEEP, "+SLEEP:")                             \
+    K(RFVDD, "+RFVDD:")                             \
+    K(SYSRAM, "+SYSRAM:")                           \
+    K(SYSADC, "+SYSADC:")                           \
+    K(SYSIOGETCFG, "+SYSIOGETCFG:")                 \
+    K(SYSGPIOREAD, "+SYSGPIOREAD:")
+
+typedef enum
+{
+#define K(name, text) ESP8266_AT_KW_##name,
+    ESP8266_AT_KEYWORDS(K)
+#undef K
+    ESP8266_AT_KW_NONE
+} ESP8266_AT_KeywordId;
+
+/*
+ * @brief Fills the slot table. Called by ESP8266_AT_Async_Init
+ * @returns false if two keywords share a slot; ESP8266_AT_KEYWORD_SEED
+ * needs changing
+ */
+bool ESP8266_AT_Keyword_Init(void);
+
+/*
+ * @param <line>: received line without CR/LF
+ * @param <len>: its length
+ * @returns the keyword <line> starts with, ESP8266_AT_KW_NONE if none
+ */
+ESP8266_AT_KeywordId ESP8266_AT_Keyword_Match(const char *line, uint16_t len);
+
+/*
+ * @brief Reference strncmp chain over the keyword list, same contract
+ * as ESP8266_AT_Keyword_Match. Kept for benchmarking
+ */
+ESP8266_AT_KeywordId ESP8266_AT_Keyword_MatchLinear(const char *line, uint16_t len);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * ESP8266_AT_LinkMonitor.h
+ * Background link quality monitor. Periodically pings a host with
+ * AT+PING and reads the AP RSSI with AT+CWJAP_CUR? through the async
+ * engine, keeping round trip statistics over a rolling window of the
+ * last ESP8266_LINKMON_WINDOW pings.
+ * Call ESP8266_LinkMonitor_Process from the main loop alongside
+ * ESP8266_AT_Async_Poll.
+ */
+
+#ifndef ESP8266_AT_LINKMONITOR_H
+#define ESP8266_AT_LINKMONITOR_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_LINKMON_WINDOW 16
+#define ESP8266_LINKMON_PING_TIMEOUT 3000
+
+typedef struct
+{
+    uint16_t min_ms;
+    uint16_t avg_ms;
+    uint16_t max_ms;
+    uint16_t jitter_ms; // mean difference between consecutive round trips
+    uint8_t loss_pct;
+    uint8_t samples;    // pings in the window, lost ones included
+    uint32_t lost;      // pings lost since Init, window or not
+    int8_t rssi;        // dBm, 0 when not yet known
+    uint8_t score;      // 0: unusable, 100: excellent
+} ESP8266_LinkStats;
+
+/*
+ * @brief Starts monitoring. Clears the window.
+ * @param <host>: host to ping, without quotes. Must stay valid while
+ * the monitor runs
+ * @param <period_ms>: time between pings
+ */
+void ESP8266_LinkMonitor_Init(const char *host, uint32_t period_ms);
+
+/*
+ * @brief Queues the next ping and RSSI query once the period elapsed
+ */
+void ESP8266_LinkMonitor_Process(void);
+
+/*
+ * @brief Computes the statistics over the current window
+ */
+void ESP8266_LinkMonitor_GetStats(ESP8266_LinkStats *stats);
+
+/*
+ * @brief Single link quality figure combining RSSI, round trip time,
+ * jitter and loss.
+ * @returns 0 to 100. 0 when no ping has completed yet
+ */
+uint8_t ESP8266_LinkMonitor_Score(void);
+
+#endif
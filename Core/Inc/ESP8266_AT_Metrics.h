@@ -0,0 +1,68 @@
+/**
+ * ESP8266_AT_Metrics.h
+ * Running statistics of the async engine for operations: per command
+ * outcome counts and round trip histograms, byte counts and parser
+ * events. The engine updates them as it runs; the application takes a
+ * snapshot, which also starts a new window, and can serialize it into
+ * a compact binary record for upload.
+ *
+ * Record layout, version 1, all counters as unsigned LEB128 varints:
+ *   'M', 1, window_ms, bytes_tx, bytes_rx, resyncs, busy, rx_overruns,
+ *   <n: u8>, then n times:
+ *   <id: u8>, sent, ok, error, timeout, rtt_hist[0..BUCKETS-1]
+ * Only commands sent at least once in the window are included.
+ */
+
+#ifndef ESP8266_AT_METRICS_H
+#define ESP8266_AT_METRICS_H
+
+#include "ESP8266_AT_Async.h"
+
+// bucket 0: < 1 ms, bucket n: [2^(n-1), 2^n) ms, last bucket open ended
+#define ESP8266_METRICS_RTT_BUCKETS 14
+#define ESP8266_METRICS_VERSION 1
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t ok;
+    uint32_t error;
+    uint32_t timeout;
+    uint16_t rtt_hist[ESP8266_METRICS_RTT_BUCKETS];
+} ESP8266_CmdMetrics;
+
+typedef struct
+{
+    uint32_t window_ms;    // length of the window the figures cover
+    uint32_t bytes_tx;     // command lines and payload
+    uint32_t bytes_rx;
+    uint32_t resyncs;      // lines dropped for overflowing the line buffer
+    uint32_t busy;         // busy p... / busy s... replies
+    uint32_t rx_overruns;  // bytes lost to a full RX ring or USART overrun
+    ESP8266_CmdMetrics cmd[ESP8266_AT_CMD_COUNT];
+} ESP8266_Metrics;
+
+/*
+ * @brief Copies the current figures and starts a new window. Call from
+ * the same context as ESP8266_AT_Async_Poll; only the counters updated
+ * from interrupts are read with interrupts masked.
+ */
+void ESP8266_Metrics_Snapshot(ESP8266_Metrics *out);
+
+/*
+ * @brief Encodes a snapshot as described above.
+ * @returns record length, 0 if it does not fit in <len>
+ */
+size_t ESP8266_Metrics_Serialize(const ESP8266_Metrics *metrics, uint8_t *buf, size_t len);
+
+// engine hooks
+
+void ESP8266_Metrics_Sent(ESP8266_AT_CmdId id, uint16_t bytes);
+void ESP8266_Metrics_Payload(uint16_t bytes); // CIPSEND payload, counted in bytes_tx
+void ESP8266_Metrics_Done(ESP8266_AT_CmdId id, ESP8266_AT_Result result, uint32_t rtt_ms);
+void ESP8266_Metrics_Resync(void);
+void ESP8266_Metrics_Busy(void);
+void ESP8266_Metrics_Received(void);  // from interrupt context
+void ESP8266_Metrics_Overrun(void);   // from interrupt context
+
+#endif
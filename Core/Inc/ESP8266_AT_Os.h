@@ -0,0 +1,113 @@
+/**
+ * ESP8266_AT_Os.h
+ * Operating system primitives used by the thread-safe driver front end
+ * in ESP8266_AT_Sync.h: mutex, event flags, message queue and a
+ * millisecond tick. Define one backend for the build:
+ *   ESP8266_AT_OS_CMSIS_RTOS2: CMSIS-RTOS2, e.g. FreeRTOS added to the
+ *   project through CubeMX (Middleware > FREERTOS > CMSIS_V2)
+ *   ESP8266_AT_OS_PTHREAD: POSIX threads, for the host tests in Test/
+ * Without either the driver stays single-threaded, as on the super-loop.
+ *
+ * Objects are created once at start-up and never deleted. No function
+ * may be called from an interrupt handler except ESP8266_AT_Os_FlagsSet.
+ */
+
+#ifndef ESP8266_AT_OS_H
+#define ESP8266_AT_OS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(ESP8266_AT_OS_CMSIS_RTOS2)
+
+#include "cmsis_os2.h"
+
+typedef osMutexId_t ESP8266_AT_OsMutex;
+typedef osEventFlagsId_t ESP8266_AT_OsFlags;
+typedef osMessageQueueId_t ESP8266_AT_OsQueue;
+
+#elif defined(ESP8266_AT_OS_PTHREAD)
+
+#include <pthread.h>
+
+typedef pthread_mutex_t ESP8266_AT_OsMutex;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint32_t bits;
+} ESP8266_AT_OsFlags;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t *items;
+    uint16_t item_size;
+    uint16_t length;
+    uint16_t head;
+    uint16_t count;
+} ESP8266_AT_OsQueue;
+
+#endif
+
+#if defined(ESP8266_AT_OS_CMSIS_RTOS2) || defined(ESP8266_AT_OS_PTHREAD)
+#define ESP8266_AT_OS
+
+#define ESP8266_AT_OS_FOREVER 0xFFFFFFFFU // timeout that never expires
+
+/*
+ * @brief Creates a mutex. It is not recursive; with CMSIS-RTOS2 it
+ * inherits the priority of the tasks it blocks
+ */
+bool ESP8266_AT_Os_MutexInit(ESP8266_AT_OsMutex *mutex);
+void ESP8266_AT_Os_MutexLock(ESP8266_AT_OsMutex *mutex);
+void ESP8266_AT_Os_MutexUnlock(ESP8266_AT_OsMutex *mutex);
+
+/*
+ * @brief Creates a set of 24 event flags, all clear
+ */
+bool ESP8266_AT_Os_FlagsInit(ESP8266_AT_OsFlags *flags);
+
+/*
+ * @brief Sets <bits>, waking the tasks waiting on any of them
+ */
+void ESP8266_AT_Os_FlagsSet(ESP8266_AT_OsFlags *flags, uint32_t bits);
+
+/*
+ * @brief Waits until any of <bits> is set and clears those of <bits>
+ * that are
+ * @param <timeout>: in ms, or ESP8266_AT_OS_FOREVER
+ * @returns the flags of <bits> that were set, 0 on timeout
+ */
+uint32_t ESP8266_AT_Os_FlagsWait(ESP8266_AT_OsFlags *flags, uint32_t bits, uint32_t timeout);
+
+/*
+ * @brief Creates a queue of <length> messages of <item_size> bytes
+ */
+bool ESP8266_AT_Os_QueueInit(ESP8266_AT_OsQueue *queue, uint16_t item_size, uint16_t length);
+
+/*
+ * @brief Copies <item> to the back of the queue, waiting up to
+ * <timeout> ms for room
+ * @returns false on timeout
+ */
+bool ESP8266_AT_Os_QueuePut(ESP8266_AT_OsQueue *queue, const void *item, uint32_t timeout);
+
+/*
+ * @brief Takes the message at the front of the queue into <item>,
+ * waiting up to <timeout> ms for one
+ * @returns false on timeout
+ */
+bool ESP8266_AT_Os_QueueGet(ESP8266_AT_OsQueue *queue, void *item, uint32_t timeout);
+
+/*
+ * @returns milliseconds since an arbitrary start; wraps around
+ */
+uint32_t ESP8266_AT_Os_Tick(void);
+
+#endif
+
+#endif
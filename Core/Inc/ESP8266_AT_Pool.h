@@ -0,0 +1,68 @@
+/**
+ * ESP8266_AT_Pool.h
+ * Fixed-block memory pools. Each pool is a static array of blocks
+ * sized at compile time, so all driver memory shows up in the map file
+ * under the pool's name and nothing comes from the heap. Allocation and
+ * release pop and push a free list in O(1) under a short PRIMASK
+ * critical section, so they are safe from interrupt handlers.
+ *
+ * Define a pool once, at file scope, then call ESP8266_AT_Pool_Init:
+ *   ESP8266_AT_POOL(link_pool, LinkBuffer, 4);
+ */
+
+#ifndef ESP8266_AT_POOL_H
+#define ESP8266_AT_POOL_H
+
+#include "ESP8266_AT.h"
+
+typedef struct
+{
+    void *free;       // first free block, linked through the blocks
+    uint8_t *storage;
+    uint16_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t high_water;
+    uint32_t failures; // allocations refused because the pool was empty
+} ESP8266_AT_Pool;
+
+typedef struct
+{
+    uint16_t count;
+    uint16_t used;
+    uint16_t high_water; // most blocks ever in use at once
+    uint32_t failures;
+} ESP8266_AT_PoolStats;
+
+/*
+ * @brief Defines a static pool of <count> blocks of <type>. A block
+ * is at least pointer sized and aligned, as the free list lives in it
+ */
+#define ESP8266_AT_POOL(name, type, count) \
+    static union                           \
+    {                                      \
+        type item;                         \
+        void *link;                        \
+    } name##_blocks[count];                \
+    static ESP8266_AT_Pool name = {NULL, (uint8_t *)name##_blocks, sizeof(name##_blocks[0]), (count), 0, 0, 0}
+
+/*
+ * @brief Links every block into the free list. Any block still held
+ * is forgotten, so only call it while the pool is not in use
+ */
+void ESP8266_AT_Pool_Init(ESP8266_AT_Pool *pool);
+
+/*
+ * @returns a block, NULL if the pool is exhausted. Callable from ISRs
+ */
+void *ESP8266_AT_Pool_Alloc(ESP8266_AT_Pool *pool);
+
+/*
+ * @brief Returns a block to its pool. Pointers that do not belong to
+ * the pool are ignored. Callable from ISRs
+ */
+void ESP8266_AT_Pool_Free(ESP8266_AT_Pool *pool, void *block);
+
+void ESP8266_AT_Pool_GetStats(const ESP8266_AT_Pool *pool, ESP8266_AT_PoolStats *stats);
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * ESP8266_AT_Power.h
+ * Duty-cycle scheduler for the ESP8266. Given the time until the next
+ * planned transmission it picks Deep-sleep (AT+GSLP), Light-sleep
+ * (AT+SLEEP=1 with AT+WAKEUPGPIO) or Modem-sleep (AT+SLEEP=2) using
+ * the energy model below, and wakes the module in time for the send.
+ * Call ESP8266_Power_Process from the main loop.
+ *
+ * Energy model, from the ESP8266EX datasheet at 3.3 V:
+ * every mode draws its sleep current for the whole interval, and
+ * leaving it costs a fixed burst at the active current. Leaving
+ * Deep-sleep is a full boot, AP association and DHCP lease.
+ */
+
+#ifndef ESP8266_AT_POWER_H
+#define ESP8266_AT_POWER_H
+
+#include "ESP8266_AT_Async.h"
+
+#define ESP8266_POWER_VDD_MV 3300
+#define ESP8266_POWER_ACTIVE_UA 70000
+#define ESP8266_POWER_MODEM_UA 15000
+#define ESP8266_POWER_LIGHT_UA 900
+#define ESP8266_POWER_DEEP_UA 20
+#define ESP8266_POWER_LIGHT_WAKE_MS (ESP8266_AT_WAKE_SETTLE_MS + 3)
+#define ESP8266_POWER_DEEP_WAKE_MS 2000 // boot, association and DHCP
+
+typedef enum
+{
+    ESP8266_POWER_ACTIVE,
+    ESP8266_POWER_MODEM_SLEEP,
+    ESP8266_POWER_LIGHT_SLEEP,
+    ESP8266_POWER_DEEP_SLEEP
+} ESP8266_PowerMode;
+
+typedef struct
+{
+    GPIO_TypeDef *wake_port; // MCU output wired to <trigger_gpio>
+    uint16_t wake_pin;
+    uint8_t trigger_gpio;    // ESP8266 GPIO that wakes it from Light-sleep
+    bool trigger_level;
+    bool deep_sleep_wired;   // XPD_DCDC connected to EXT_RSTB
+    // called once the module is usable again. After Deep-sleep the
+    // module has rebooted and every _CUR setting has to be re-applied
+    void (*on_wake)(ESP8266_PowerMode slept_in);
+} ESP8266_PowerConfig;
+
+/*
+ * @brief Sets up the scheduler. wake_pin must already be configured as
+ * an output; it is driven to the inactive level here.
+ */
+void ESP8266_Power_Init(const ESP8266_PowerConfig *config);
+
+/*
+ * @brief Modelled energy for one reporting interval spent in <mode>,
+ * wake-up cost included.
+ * @returns energy in uJ
+ */
+uint32_t ESP8266_Power_Energy(ESP8266_PowerMode mode, uint32_t interval_ms);
+
+/*
+ * @brief Picks the mode with the least modelled energy for the gap
+ * without sending anything.
+ */
+ESP8266_PowerMode ESP8266_Power_Plan(uint32_t next_tx_ms);
+
+/*
+ * @brief Puts the module to sleep until the next transmission. Only
+ * acts when the async engine is idle and the module is awake.
+ * @param <next_tx_ms>: time from now until the module is needed
+ * @returns the mode entered, ESP8266_POWER_ACTIVE when nothing was done
+ */
+ESP8266_PowerMode ESP8266_Power_Sleep(uint32_t next_tx_ms);
+
+/*
+ * @brief Wakes the module ahead of schedule, e.g. for an unplanned
+ * send. Has no effect in Deep-sleep, which only ends on its timer.
+ */
+void ESP8266_Power_Wake(void);
+
+/*
+ * @returns true when the module is awake and accepting commands
+ */
+bool ESP8266_Power_Awake(void);
+
+/*
+ * @brief Runs the wake-up sequence when a sleep period ends
+ */
+void ESP8266_Power_Process(void);
+
+#endif
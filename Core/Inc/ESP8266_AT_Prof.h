@@ -0,0 +1,129 @@
+/**
+ * ESP8266_AT_Prof.h
+ * Cycle-level instrumentation of the driver hot path. Compiled out
+ * unless ESP8266_AT_PROFILE is defined; the ESP8266_PROF_* hooks then
+ * expand to nothing.
+ * On target, timestamps are DWT->CYCCNT cycles. Elsewhere they are
+ * CLOCK_MONOTONIC nanoseconds, so host runs of the same code report
+ * comparable figures.
+ * Spans are kept as histograms with two octaves per bucket: bucket n
+ * counts spans of [4^(n-1), 4^n) ticks, bucket 0 counts zero spans.
+ * The receive interrupt is also tracked exactly, as the extremes of
+ * its duration and of the spacing of back-to-back interrupts: bytes of
+ * a burst arrive one byte time apart, so the spread of that spacing is
+ * the jitter of the interrupt entry.
+ */
+
+#ifndef ESP8266_AT_PROF_H
+#define ESP8266_AT_PROF_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_PROF_BUCKETS 16
+
+typedef enum
+{
+    ESP8266_PROF_FORMAT_BEGIN,
+    ESP8266_PROF_FORMAT_END,
+    ESP8266_PROF_TX_START,
+    ESP8266_PROF_TX_DONE,
+    ESP8266_PROF_FIRST_BYTE,
+    ESP8266_PROF_RESULT,
+    ESP8266_PROF_ISR_ENTER,
+    ESP8266_PROF_ISR_EXIT,
+    ESP8266_PROF_POINTS
+} ESP8266_ProfPoint;
+
+// per command spans
+typedef enum
+{
+    ESP8266_PROF_SPAN_FORMAT,     // FORMAT_BEGIN to FORMAT_END
+    ESP8266_PROF_SPAN_TX,         // TX_START to TX_DONE
+    ESP8266_PROF_SPAN_FIRST_BYTE, // TX_DONE to FIRST_BYTE
+    ESP8266_PROF_SPAN_ROUND_TRIP, // TX_START to RESULT
+    ESP8266_PROF_CMD_SPANS
+} ESP8266_ProfCmdSpan;
+
+// driver wide spans
+typedef enum
+{
+    ESP8266_PROF_SPAN_ISR,        // ISR_ENTER to ISR_EXIT
+    ESP8266_PROF_SPAN_PARSE_BYTE, // parser cost per received byte
+    ESP8266_PROF_DRV_SPANS
+} ESP8266_ProfDrvSpan;
+
+typedef struct
+{
+    uint32_t isr_min; // ISR_ENTER to ISR_EXIT
+    uint32_t isr_max;
+    uint32_t gap_min; // ISR_ENTER to ISR_ENTER within a burst
+    uint32_t gap_max;
+    uint32_t gaps;    // back-to-back interrupts measured
+} ESP8266_ProfIsrStats;
+
+#ifdef ESP8266_AT_PROFILE
+
+#if defined(__ARM_ARCH)
+#define ESP8266_PROF_NOW() (DWT->CYCCNT)
+#else
+#include <time.h>
+static inline uint32_t ESP8266_Prof_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#define ESP8266_PROF_NOW() ESP8266_Prof_Ns()
+#endif
+
+#define ESP8266_PROF_MARK(point, cmd) ESP8266_Prof_Mark(point, cmd)
+#define ESP8266_PROF_PARSE(ticks, bytes) ESP8266_Prof_Parse(ticks, bytes)
+
+/*
+ * @brief Starts the DWT cycle counter and clears all histograms
+ */
+void ESP8266_Prof_Init(void);
+
+/*
+ * @brief Timestamps a hook point and records the span it closes
+ */
+void ESP8266_Prof_Mark(ESP8266_ProfPoint point, ESP8266_AT_CmdId cmd);
+
+/*
+ * @brief Sets the time one byte takes on the wire, e.g. 10 bits at
+ * the UART baud rate in CPU cycles. Interrupts less than 1.5 byte
+ * times apart are taken as back-to-back. Gaps are not tracked until
+ * this is called
+ */
+void ESP8266_Prof_ByteTime(uint32_t ticks);
+
+/*
+ * @brief Receive interrupt duration and entry spacing since Init.
+ * Jitter is gap_max - gap_min
+ */
+void ESP8266_Prof_IsrStats(ESP8266_ProfIsrStats *stats);
+
+/*
+ * @brief Records the parser cost of one batch of received bytes
+ */
+void ESP8266_Prof_Parse(uint32_t ticks, uint32_t bytes);
+
+/*
+ * @returns the histogram of one span of one command type
+ */
+const uint16_t *ESP8266_Prof_CmdHistogram(ESP8266_AT_CmdId cmd, ESP8266_ProfCmdSpan span);
+
+/*
+ * @returns the histogram of one driver wide span
+ */
+const uint16_t *ESP8266_Prof_DrvHistogram(ESP8266_ProfDrvSpan span);
+
+#else
+
+#define ESP8266_PROF_NOW() 0U
+#define ESP8266_PROF_MARK(point, cmd) ((void)0)
+#define ESP8266_PROF_PARSE(ticks, bytes) ((void)(ticks), (void)(bytes))
+
+#endif
+
+#endif
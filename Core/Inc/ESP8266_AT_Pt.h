@@ -0,0 +1,165 @@
+/**
+ * ESP8266_AT_Pt.h
+ * Protothreads for the super-loop: multi-step sequences over the async
+ * engine written as straight-line code. A protothread is a function
+ * that returns ESP8266_AT_PT_WAITING wherever it has to wait and picks
+ * up there on its next call, so the main loop calls it once per pass
+ * next to ESP8266_AT_Async_Poll. It needs no stack of its own: the
+ * resume point and the result of the last command, 4 bytes in all, are
+ * the whole state.
+ *
+ * Locals do not survive a wait; keep what must in a struct that starts
+ * with the ESP8266_AT_Pt, which also lets line handlers reach it. A
+ * switch statement cannot span a wait either, as the resume points are
+ * case labels of a switch.
+ *
+ *   typedef struct
+ *   {
+ *       ESP8266_AT_Pt pt;
+ *       ESP8266_AT_Arg args[3]; // read again while the queue is full
+ *       const uint8_t *data;
+ *       uint16_t len, sent;
+ *   } Upload;
+ *
+ *   static ESP8266_AT_PtState _Upload(Upload *up)
+ *   {
+ *       ESP8266_AT_PT_BEGIN(&up->pt);
+ *       up->args[0].s = "ssid";
+ *       up->args[1].s = "password";
+ *       ESP8266_AT_PT_AWAIT_CMD(&up->pt, ESP8266_AT_CMD_CWJAP_CUR, ESP8266_AT_SET, up->args, 2, NULL);
+ *       up->args[0].s = "TCP";
+ *       up->args[1].s = "example.com";
+ *       up->args[2].u = 80;
+ *       ESP8266_AT_PT_AWAIT_CMD(&up->pt, ESP8266_AT_CMD_CIPSTART, ESP8266_AT_SET, up->args, 3, NULL);
+ *       if (up->pt.result != ESP8266_AT_OK)
+ *           ESP8266_AT_PT_EXIT(&up->pt);
+ *       up->args[0].u = up->len;
+ *       ESP8266_AT_PT_AWAIT_CMD(&up->pt, ESP8266_AT_CMD_CIPSEND, ESP8266_AT_SET, up->args, 1, NULL);
+ *       if (up->pt.result != ESP8266_AT_OK)
+ *           ESP8266_AT_PT_EXIT(&up->pt);
+ *       // the module may give up before its prompt, or while reading
+ *       ESP8266_AT_PT_WAIT_UNTIL(&up->pt, ESP8266_AT_Async_PayloadReady() ||
+ *                                             ESP8266_AT_Async_PayloadResult() != ESP8266_AT_PENDING);
+ *       for (up->sent = 0; up->sent < up->len &&
+ *                          ESP8266_AT_Async_PayloadResult() == ESP8266_AT_PENDING;)
+ *       {
+ *           up->sent += ESP8266_AT_Async_Write(up->data + up->sent, up->len - up->sent);
+ *           ESP8266_AT_PT_YIELD(&up->pt);
+ *       }
+ *       ESP8266_AT_PT_WAIT_UNTIL(&up->pt, ESP8266_AT_Async_PayloadResult() != ESP8266_AT_PENDING);
+ *       // SEND OK, or ESP8266_AT_Async_PayloadResult() tells why not
+ *       ESP8266_AT_PT_END(&up->pt);
+ *   }
+ *
+ *   ESP8266_AT_PT_INIT(&upload.pt);
+ *   while (1)
+ *   {
+ *       ESP8266_AT_Async_Poll();
+ *       _Upload(&upload);
+ *   }
+ */
+
+#ifndef ESP8266_AT_PT_H
+#define ESP8266_AT_PT_H
+
+#include "ESP8266_AT_Async.h"
+
+// the resume points are reached by falling into them
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define ESP8266_AT_PT_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define ESP8266_AT_PT_FALLTHROUGH
+#endif
+
+// pt.result while the command of ESP8266_AT_PT_AWAIT_CMD is not queued yet
+#define ESP8266_AT_PT_UNSENT 0xFF
+
+typedef enum
+{
+    ESP8266_AT_PT_WAITING,
+    ESP8266_AT_PT_DONE
+} ESP8266_AT_PtState;
+
+typedef struct
+{
+    uint16_t line;  // resume point, 0 at the start
+    uint8_t result; // ESP8266_AT_Result of the last awaited command
+} ESP8266_AT_Pt;
+
+/*
+ * @brief Starts the protothread from the top. Not while a command of
+ * ESP8266_AT_PT_AWAIT_CMD is queued: its result would land later
+ */
+#define ESP8266_AT_PT_INIT(pt) ((pt)->line = 0)
+
+#define ESP8266_AT_PT_BEGIN(pt) \
+    switch ((pt)->line)         \
+    {                           \
+    case 0:
+
+/*
+ * @brief Ends the protothread. Later calls return ESP8266_AT_PT_DONE
+ * until ESP8266_AT_PT_INIT starts it again
+ */
+#define ESP8266_AT_PT_END(pt) \
+    }                         \
+    (pt)->line = __LINE__;    \
+    return ESP8266_AT_PT_DONE
+
+#define ESP8266_AT_PT_EXIT(pt)     \
+    do                             \
+    {                              \
+        (pt)->line = __LINE__;     \
+        return ESP8266_AT_PT_DONE; \
+    case __LINE__:;                \
+        return ESP8266_AT_PT_DONE; \
+    } while (0)
+
+/*
+ * @brief Returns ESP8266_AT_PT_WAITING until <cond> holds. <cond> is
+ * evaluated again on every call
+ */
+#define ESP8266_AT_PT_WAIT_UNTIL(pt, cond) \
+    do                                     \
+    {                                      \
+        (pt)->line = __LINE__;             \
+        ESP8266_AT_PT_FALLTHROUGH;         \
+    case __LINE__:                         \
+        if (!(cond))                       \
+            return ESP8266_AT_PT_WAITING;  \
+    } while (0)
+
+/*
+ * @brief Returns ESP8266_AT_PT_WAITING once, giving the main loop a pass
+ */
+#define ESP8266_AT_PT_YIELD(pt)       \
+    do                                \
+    {                                 \
+        (pt)->line = __LINE__;        \
+        return ESP8266_AT_PT_WAITING; \
+    case __LINE__:;                   \
+    } while (0)
+
+/*
+ * @brief Queues a command with ESP8266_AT_Async_SubmitCmd, retrying
+ * while the queue is full, and waits for it to complete. The result is
+ * then in (pt)->result. <args> is read on every retry, so it must not
+ * be a local. <on_line> gets <pt> as its context
+ */
+#define ESP8266_AT_PT_AWAIT_CMD(pt, id, form, args, count, on_line)                          \
+    do                                                                                       \
+    {                                                                                        \
+        (pt)->result = ESP8266_AT_PT_UNSENT;                                                 \
+        ESP8266_AT_PT_WAIT_UNTIL(pt, ESP8266_AT_Pt_Cmd((pt), (id), (form), (args), (count), \
+                                                       (on_line)));                          \
+    } while (0)
+
+/*
+ * @brief Step of ESP8266_AT_PT_AWAIT_CMD: queues the command unless it
+ * is queued already
+ * @returns true once the command has completed
+ */
+bool ESP8266_AT_Pt_Cmd(ESP8266_AT_Pt *pt, ESP8266_AT_CmdId id, uint8_t form,
+                       const ESP8266_AT_Arg *args, uint8_t count, ESP8266_AT_LineHandler on_line);
+
+#endif
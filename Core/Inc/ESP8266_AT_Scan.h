@@ -0,0 +1,26 @@
+/**
+ * ESP8266_AT_Scan.h
+ * Word-at-a-time byte search for the RX parser. Four bytes are tested
+ * per step: on Cortex-M4 with the DSP extension through __UQSUB8, which
+ * turns every byte equal to the target into 1 in a single instruction;
+ * elsewhere through the portable SWAR zero-byte test.
+ */
+
+#ifndef ESP8266_AT_SCAN_H
+#define ESP8266_AT_SCAN_H
+
+#include "ESP8266_AT.h"
+
+/*
+ * @brief Finds the first occurrence of <c> in <data>
+ * @returns its index, <len> when not found
+ */
+size_t ESP8266_AT_Scan(const uint8_t *data, size_t len, uint8_t c);
+
+/*
+ * @brief Reference bytewise search, same contract as ESP8266_AT_Scan.
+ * Kept for benchmarking
+ */
+size_t ESP8266_AT_ScanBytewise(const uint8_t *data, size_t len, uint8_t c);
+
+#endif
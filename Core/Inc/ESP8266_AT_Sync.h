@@ -0,0 +1,80 @@
+/**
+ * ESP8266_AT_Sync.h
+ * Thread-safe front end of the async engine for builds with an RTOS,
+ * see ESP8266_AT_Os.h. One driver task owns the engine: it runs
+ * ESP8266_AT_Sync_Task and is the only task that calls into
+ * ESP8266_AT_Async. Any other task calls ESP8266_AT_Sync_Cmd, which
+ * posts the command to the driver task through a message queue and
+ * blocks on its own event flag until the command completes.
+ *
+ * The mutex is held only to claim and release a waiter slot, never
+ * while a command is queued or in flight, so several tasks can have
+ * commands outstanding at once. The engine sends them one at a time in
+ * priority order; requests it has no room for yet wait in the driver
+ * task by priority, so a HIGH one never queues behind a NORMAL one.
+ *
+ * The blocking ESP8266_AT_* functions of ESP8266_AT.h and the other
+ * driver modules bypass this front end; under an RTOS call them from
+ * the driver task only, or not at all.
+ */
+
+#ifndef ESP8266_AT_SYNC_H
+#define ESP8266_AT_SYNC_H
+
+#include "ESP8266_AT_Async.h"
+#include "ESP8266_AT_Os.h"
+
+#ifdef ESP8266_AT_OS
+
+#define ESP8266_AT_SYNC_WAITERS 8 // commands outstanding at once, at most 24
+#define ESP8266_AT_SYNC_POLL_MS 1 // driver task poll period while idle
+
+typedef struct
+{
+    uint32_t calls;
+    uint32_t no_waiter; // calls refused because every waiter slot was taken
+    uint32_t max_ms;    // longest time a caller was blocked
+} ESP8266_AT_SyncStats;
+
+/*
+ * @brief Creates the mutex, event flags and request queue. Call once
+ * after ESP8266_AT_Async_Init and before any task calls
+ * ESP8266_AT_Sync_Cmd
+ */
+bool ESP8266_AT_Sync_Init(void);
+
+/*
+ * @brief Body of the driver task: hands queued requests to the engine
+ * and polls it. Never returns. Give the task a priority above the
+ * callers so responses are parsed while they are blocked
+ * @param <arg>: unused, for osThreadNew and pthread_create
+ */
+void ESP8266_AT_Sync_Task(void *arg);
+
+/*
+ * @brief One pass of ESP8266_AT_Sync_Task, waiting up to <wait_ms> for
+ * a request when the engine has nothing to do
+ */
+void ESP8266_AT_Sync_Run(uint32_t wait_ms);
+
+/*
+ * @brief Runs a command from the ESP8266_AT_COMMANDS table and blocks
+ * the calling task until it completes. Callable from any task but the
+ * driver task, and not from the handlers
+ * @param <prio>, <id>, <form>, <args>, <count>, <timeout>: as for
+ * ESP8266_AT_Async_SubmitPrio. <args> and the strings they point to
+ * must stay valid until the call returns
+ * @param <on_line>: nullable. Runs in the driver task
+ * @returns the result of the command; ESP8266_AT_ERROR if it could not
+ * be queued. Unless the engine is held, every queued command
+ * completes, at the latest with ESP8266_AT_TIMEOUT
+ */
+ESP8266_AT_Result ESP8266_AT_Sync_Cmd(ESP8266_AT_Priority prio, ESP8266_AT_CmdId id, uint8_t form,
+                                      const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                      ESP8266_AT_LineHandler on_line, void *ctx);
+
+void ESP8266_AT_Sync_GetStats(ESP8266_AT_SyncStats *stats);
+
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * ESP8266_AT_Text.h
+ * Fixed-cost formatting and parsing of the values AT commands carry:
+ * decimal integers, dotted-quad IPv4 addresses, MAC addresses and
+ * quoted strings with AT escaping. Nothing allocates; every routine
+ * writes into the caller's buffer and handles one value, so the cost
+ * is bounded by the value's length.
+ *
+ * Formatters return the number of characters written and do not
+ * terminate the output. Parsers return a pointer just past the value
+ * they consumed, NULL if there was no valid value at <p>.
+ */
+
+#ifndef ESP8266_AT_TEXT_H
+#define ESP8266_AT_TEXT_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_AT_UINT_CHARS 10 // "4294967295"
+#define ESP8266_AT_INT_CHARS 11  // "-2147483648"
+#define ESP8266_AT_IPV4_CHARS 15 // "255.255.255.255"
+#define ESP8266_AT_MAC_CHARS 17  // "aa:bb:cc:dd:ee:ff"
+
+/*
+ * @brief Writes <value> in decimal
+ * @param <buf>: room for ESP8266_AT_UINT_CHARS
+ */
+uint8_t ESP8266_AT_FormatUint(char *buf, uint32_t value);
+
+/*
+ * @brief Writes <value> in decimal, with a leading '-' when negative
+ * @param <buf>: room for ESP8266_AT_INT_CHARS
+ */
+uint8_t ESP8266_AT_FormatInt(char *buf, int32_t value);
+
+/*
+ * @brief Writes <ip> as a.b.c.d
+ * @param <ip>: address bytes in transmission order
+ * @param <buf>: room for ESP8266_AT_IPV4_CHARS
+ */
+uint8_t ESP8266_AT_FormatIPv4(char *buf, const uint8_t ip[4]);
+
+/*
+ * @brief Writes <mac> as aa:bb:cc:dd:ee:ff, lower case as the module does
+ * @param <buf>: room for ESP8266_AT_MAC_CHARS
+ */
+uint8_t ESP8266_AT_FormatMac(char *buf, const uint8_t mac[6]);
+
+/*
+ * @brief Writes <str> in double quotes, escaping '"', ',' and '\'
+ * with '\' as AT string parameters require
+ * @param <size>: room in <buf>
+ * @returns characters written, 0 if the result does not fit
+ */
+uint16_t ESP8266_AT_FormatQuoted(char *buf, size_t size, const char *str);
+
+/*
+ * @brief Reads an unsigned decimal number. Values past UINT32_MAX are
+ * rejected
+ */
+const char *ESP8266_AT_ParseUint(const char *p, uint32_t *value);
+
+/*
+ * @brief Reads a decimal number with an optional leading '-'
+ */
+const char *ESP8266_AT_ParseInt(const char *p, int32_t *value);
+
+/*
+ * @brief Reads a.b.c.d, each part 0 to 255
+ */
+const char *ESP8266_AT_ParseIPv4(const char *p, uint8_t ip[4]);
+
+/*
+ * @brief Reads six ':' separated hex byte pairs, either case
+ */
+const char *ESP8266_AT_ParseMac(const char *p, uint8_t mac[6]);
+
+/*
+ * @brief Reads a double quoted string and undoes '\' escapes. <p> must
+ * point at the opening quote
+ * @param <out>: nullable. Receives the string, always terminated,
+ * truncated to <size> - 1 characters
+ * @returns past the closing quote, NULL if it is missing
+ */
+const char *ESP8266_AT_ParseQuoted(const char *p, char *out, size_t size);
+
+#endif
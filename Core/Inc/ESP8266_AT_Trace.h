@@ -0,0 +1,60 @@
+/**
+ * ESP8266_AT_Trace.h
+ * Binary trace of AT traffic in a RAM ring. Each event is a fixed
+ * 12 byte record; nothing is formatted on target. Compiled out unless
+ * ESP8266_AT_TRACE is defined.
+ *
+ * ESP8266_Trace_Export writes a dump for the host side decoder,
+ * Test/Src/Trace_Decode.c:
+ *   'T', ESP8266_TRACE_VERSION, <event size: u8>, <reserved: u8>,
+ *   <write index: u32 LE>, <events, oldest first>
+ * The write index counts every event ever recorded, so index minus the
+ * number of events in the dump is the number lost to wrap-around.
+ * Multi-byte fields are little endian, as stored by the Cortex-M4.
+ */
+
+#ifndef ESP8266_AT_TRACE_H
+#define ESP8266_AT_TRACE_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_TRACE_LEN 128 // events, must be a power of two
+#define ESP8266_TRACE_VERSION 1
+
+typedef enum
+{
+    ESP8266_TRACE_TX,     // command line sent
+    ESP8266_TRACE_RX,     // response line of the command in flight
+    ESP8266_TRACE_URC,    // line received with no command in flight
+    ESP8266_TRACE_RESULT, // final result; len holds the ESP8266_AT_Result
+    ESP8266_TRACE_DROP    // line dropped by the parser; len holds its length
+} ESP8266_TraceDir;
+
+typedef struct
+{
+    uint32_t time_ms; // HAL_GetTick
+    uint8_t dir;      // ESP8266_TraceDir
+    uint8_t cmd;      // ESP8266_AT_CmdId of the command in flight
+    uint16_t len;     // payload length
+    char prefix[4];   // first bytes of the payload, zero padded
+} ESP8266_TraceEvent;
+
+#ifdef ESP8266_AT_TRACE
+
+#define ESP8266_TRACE(dir, cmd, data, len) ESP8266_Trace_Record(dir, cmd, data, len)
+
+void ESP8266_Trace_Record(ESP8266_TraceDir dir, ESP8266_AT_CmdId cmd, const char *data, uint16_t len);
+
+/*
+ * @brief Writes the trace dump described above
+ * @returns bytes written, 0 if <len> cannot hold the header
+ */
+size_t ESP8266_Trace_Export(uint8_t *buf, size_t len);
+
+#else
+
+#define ESP8266_TRACE(dir, cmd, data, len) ((void)0)
+
+#endif
+
+#endif
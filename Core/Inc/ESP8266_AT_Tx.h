@@ -0,0 +1,76 @@
+/**
+ * ESP8266_AT_Tx.h
+ * Double-buffered UART transmitter. One buffer is drained by DMA while
+ * the other is filled; when the DMA transfer completes the buffers swap
+ * straight from the transmit complete interrupt, so queued bytes follow
+ * each other without waiting for the main loop.
+ *
+ * Bytes can be copied in with ESP8266_AT_Tx_Write, or formatted in
+ * place: ESP8266_AT_Tx_Reserve hands out room in the fill buffer and
+ * ESP8266_AT_Tx_Commit queues what was written there. The buffers do
+ * not swap between the two calls.
+ *
+ * Without a DMA stream linked to the UART (hdmatx) the transfers fall
+ * back to interrupt mode.
+ */
+
+#ifndef ESP8266_AT_TX_H
+#define ESP8266_AT_TX_H
+
+#include "ESP8266_AT.h"
+
+#define ESP8266_AT_TX_BUF_LEN 256 // per buffer
+
+/*
+ * @brief Binds the transmitter to a UART and drops anything queued
+ */
+void ESP8266_AT_Tx_Init(UART_HandleTypeDef *uart);
+
+/*
+ * @brief Returns room for <len> bytes in the fill buffer. Write them,
+ * then call ESP8266_AT_Tx_Commit. Only one reservation may be open.
+ * @returns pointer to the room, NULL if the fill buffer has less free
+ */
+uint8_t *ESP8266_AT_Tx_Reserve(uint16_t len);
+
+/*
+ * @brief Queues <len> bytes written to the reserved room and closes the
+ * reservation. Starts a transfer if the UART is idle.
+ * @param <len>: bytes actually written, at most the reserved length
+ */
+void ESP8266_AT_Tx_Commit(uint16_t len);
+
+/*
+ * @brief Copies <data> into the fill buffer and queues it
+ * @returns number of bytes queued, less than <len> when the fill buffer
+ * is full
+ */
+uint16_t ESP8266_AT_Tx_Write(const void *data, uint16_t len);
+
+/*
+ * @brief Starts a transfer of bytes left queued because the UART was
+ * busy elsewhere when they were committed. Call from the main loop
+ */
+void ESP8266_AT_Tx_Kick(void);
+
+/*
+ * @returns free bytes in the fill buffer
+ */
+uint16_t ESP8266_AT_Tx_Room(void);
+
+/*
+ * @returns true while bytes are queued or being transmitted
+ */
+bool ESP8266_AT_Tx_Busy(void);
+
+/*
+ * @brief Stops the transfer in progress and drops everything queued
+ */
+void ESP8266_AT_Tx_Abort(void);
+
+/*
+ * @brief Forward HAL_UART_TxCpltCallback here. Starts the next buffer
+ */
+void ESP8266_AT_Tx_CpltCallback(UART_HandleTypeDef *uart);
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * ESP8266_AT_TxPower.h
+ * Closed-loop RF TX power control. Uses the RSSI, jitter and loss
+ * figures of ESP8266_AT_LinkMonitor, which must be running, plus the
+ * VDD33 reading of AT+RFVDD? and send failures reported by the
+ * application. Power is lowered slowly while the link has margin and
+ * raised quickly as soon as it degrades. Changes are sent with
+ * AT+RFPOWER only when the value moves.
+ * Call ESP8266_TxPower_Process from the main loop.
+ */
+
+#ifndef ESP8266_AT_TXPOWER_H
+#define ESP8266_AT_TXPOWER_H
+
+#include "ESP8266_AT_LinkMonitor.h"
+
+#define ESP8266_TXPOWER_STEP_DOWN 2  // 0.5 dB per period with margin
+#define ESP8266_TXPOWER_STEP_UP 12   // 3 dB per period when degraded
+#define ESP8266_TXPOWER_LOW_VDD_MV 2700
+
+typedef struct
+{
+    uint32_t period_ms;
+    int8_t target_rssi;   // dBm the link should keep, e.g. -67
+    uint8_t hysteresis;   // dB above target before power is lowered
+    uint16_t max_jitter_ms;
+    uint8_t min_power;    // AT+RFPOWER units, 0.25 dBm
+    uint8_t max_power;
+    uint8_t low_vdd_max_power; // ceiling while VDD33 is below ESP8266_TXPOWER_LOW_VDD_MV
+} ESP8266_TxPowerConfig;
+
+/*
+ * @brief Starts the controller at config->max_power
+ */
+void ESP8266_TxPower_Init(const ESP8266_TxPowerConfig *config);
+
+/*
+ * @brief Reports the outcome of an application send. Failures count
+ * as retransmissions and push the power up at the next update
+ */
+void ESP8266_TxPower_ReportSend(bool ok);
+
+/*
+ * @brief Runs one control step every period
+ */
+void ESP8266_TxPower_Process(void);
+
+/*
+ * @brief Forgets the power last acknowledged, so the next update sends
+ * it again. The async engine calls it when the module restarts and
+ * comes back at its default power
+ */
+void ESP8266_TxPower_Invalidate(void);
+
+/*
+ * @returns the TX power the controller is driving to, in AT+RFPOWER
+ * units
+ */
+uint8_t ESP8266_TxPower_Get(void);
+
+/*
+ * @returns last VDD33 reading in mV, 0 when unknown
+ */
+uint16_t ESP8266_TxPower_Vdd(void);
+
+#endif
@@ -36,11 +36,21 @@ extern "C" {
 
 /* Exported types ------------------------------------------------------------*/
 /* USER CODE BEGIN ET */
+typedef enum
+{
+  CLOCK_PROFILE_HSI_16MHZ,  /* HSI direct, 0 WS, lowest power */
+  CLOCK_PROFILE_PLL_84MHZ,  /* PLL from HSI, 2 WS, voltage scale 3 */
+  CLOCK_PROFILE_PLL_180MHZ  /* PLL from HSI, 5 WS, scale 1 + over-drive,
+                               PLL48CLK from PLLSAI */
+} ClockProfile;
 
 /* USER CODE END ET */
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
+#ifndef CLOCK_PROFILE
+#define CLOCK_PROFILE CLOCK_PROFILE_HSI_16MHZ
+#endif
 
 /* USER CODE END EC */
 
@@ -53,6 +63,8 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void SystemClock_ConfigProfile(ClockProfile profile);
+void SystemClock_Restore(void);
 
 /* USER CODE END EFP */
 
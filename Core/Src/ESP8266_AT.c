@@ -1,65 +1,358 @@
 #include "ESP8266_AT.h"
+#include "ESP8266_AT_Config.h"
+#include "ESP8266_AT_Text.h"
 
-void ESP8266_AT(UART_HandleTypeDef *uart, uint8_t timeout)
+#define _UNPACK(...) __VA_ARGS__
+
+// a sentinel keeps commands without parameters from declaring empty arrays
+#define X(name, verb, forms, timeout, reply, required, params) \
+    static const ESP8266_AT_Param _params_##name[] = {_UNPACK params{ESP8266_AT_PARAM_UINT, 0, 0}};
+ESP8266_AT_COMMANDS(X)
+#undef X
+
+const ESP8266_AT_Command ESP8266_AT_Commands[ESP8266_AT_CMD_OTHER] = {
+#define X(name, verb, forms, timeout, reply, required, params)                        \
+    {verb, reply, _params_##name, timeout, sizeof(verb) - 1, sizeof(reply) - 1, forms, \
+     required, sizeof(_params_##name) / sizeof(ESP8266_AT_Param) - 1},
+    ESP8266_AT_COMMANDS(X)
+#undef X
+};
+
+// commands the blocking API sends without arguments: function, command, form
+#define PLAIN_COMMANDS(P)                                         \
+    P(ESP8266_AT, AT, ESP8266_AT_EXEC)                            \
+    P(ESP8266_AT_RST, RST, ESP8266_AT_EXEC)                       \
+    P(ESP8266_AT_GMR, GMR, ESP8266_AT_EXEC)                       \
+    P(ESP8266_RESTORE, RESTORE, ESP8266_AT_EXEC)                  \
+    P(ESP8266_AT_UART_CUR_QUERY, UART_CUR, ESP8266_AT_QUERY)      \
+    P(ESP8266_AT_UART_DEF_QUERY, UART_DEF, ESP8266_AT_QUERY)      \
+    P(ESP8266_AT_SLEEP_QUERY, SLEEP, ESP8266_AT_QUERY)            \
+    P(ESP8266_AT_RFVDD_QUERY, RFVDD, ESP8266_AT_QUERY)            \
+    P(ESP8266_AT_RFVDD_EXECUTRE, RFVDD, ESP8266_AT_EXEC)          \
+    P(ESP8266_AT_SYSRAM, SYSRAM, ESP8266_AT_QUERY)                \
+    P(ESP8266_AT_SYSADC, SYSADC, ESP8266_AT_QUERY)                \
+    P(ESP8266_AT_CWMODE_CUR_QUERY, CWMODE_CUR, ESP8266_AT_QUERY)  \
+    P(ESP8266_AT_CIPMUX_QUERY, CIPMUX, ESP8266_AT_QUERY)          \
+    P(ESP8266_AT_CIPMODE_QUERY, CIPMODE, ESP8266_AT_QUERY)
+
+static void _Send(UART_HandleTypeDef *uart, ESP8266_AT_CmdId id, uint8_t form,
+                  const ESP8266_AT_Arg *args, uint8_t count, uint8_t timeout)
 {
-    _Transmit(uart, "AT", timeout);
+    // the reply is not read here, so queries always go out
+    if (form == ESP8266_AT_SET && ESP8266_AT_Config_Current(id, form, args, count))
+        return;
+
+    char cmd[ESP8266_AT_LINE_MAX];
+    uint16_t len = ESP8266_AT_Format(cmd, sizeof(cmd) - 1, id, form, args, count);
+    if (len == 0)
+        return;
+
+    cmd[len++] = '\r';
+    cmd[len++] = '\n';
+    // the module may still refuse the command, so the setting stays
+    // unknown until a query or the async engine sees it confirmed
+    ESP8266_AT_Config_Sent(id, form);
+    HAL_UART_Transmit(uart, (uint8_t *)cmd, len, timeout);
 }
 
-void ESP8266_AT_RST(UART_HandleTypeDef *uart, uint8_t timeout)
+#define P(function, name, form)                                       \
+    void function(UART_HandleTypeDef *uart, uint8_t timeout)          \
+    {                                                                 \
+        _Send(uart, ESP8266_AT_CMD_##name, form, NULL, 0, timeout);   \
+    }
+PLAIN_COMMANDS(P)
+#undef P
+
+void ESP8266_AT_GSLP(UART_HandleTypeDef *uart, uint32_t time, uint8_t timeout)
 {
-    _Transmit(uart, "AT+RST", timeout);
+    ESP8266_AT_Arg args[] = {{.u = time > ESP8266_AT_GSLP_MAX_MS ? ESP8266_AT_GSLP_MAX_MS : time}};
+
+    _Send(uart, ESP8266_AT_CMD_GSLP, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_GMR(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_ATE(UART_HandleTypeDef *uart, bool echo_on, uint8_t timeout)
 {
-    _Transmit(uart, "AT+GMR", timeout);
+    ESP8266_AT_Arg args[] = {{.u = echo_on}};
+
+    _Send(uart, ESP8266_AT_CMD_ATE, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_GSLP(UART_HandleTypeDef *uart, uint8_t time, uint8_t timeout)
+void ESP8266_AT_UART_CUR_SET(UART_HandleTypeDef *uart, uint32_t baudrate, uint8_t databits, uint8_t stopbits, uint8_t parity, uint8_t flow_control, uint8_t timeout)
 {
-    int length = snprintf(NULL, 0, "%d", time);
-    char time_as_str[length + 1];
-    strncpy(time_as_str, snprintf(time_as_str, length + 1, "%d", time), length); // remove null terminator
+    ESP8266_AT_Arg args[] = {{.u = baudrate}, {.u = databits}, {.u = stopbits}, {.u = parity}, {.u = flow_control}};
 
-    _Transmit(uart, strcat("AT+GSLP=", time_as_str), timeout);
+    _Send(uart, ESP8266_AT_CMD_UART_CUR, ESP8266_AT_SET, args, 5, timeout);
 }
 
-void ESP8266_ATE(UART_HandleTypeDef *uart, bool echo_on, uint8_t timeout)
+void ESP8266_AT_UART_DEF_SET(UART_HandleTypeDef *uart, uint8_t timeout)
 {
-    if (echo_on)
-        _Transmit(uart, "ATE1", timeout);
-    else
-        _Transmit(uart, "ATE0", timeout);
+    (void)uart;
+    (void)timeout;
 }
 
-void ESP8266_RESTORE(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_AT_SLEEP_SET(UART_HandleTypeDef *uart, uint8_t sleep_mode, uint8_t timeout)
 {
-    _Transmit(uart, "AT+RESTORE", timeout);
+    ESP8266_AT_Arg args[] = {{.u = sleep_mode}};
+
+    _Send(uart, ESP8266_AT_CMD_SLEEP, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_UART_CUR_QUERY(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_AT_WAKEUPGPIO(UART_HandleTypeDef *uart, bool enable,
+                           uint8_t trigger_gpio, bool trigger_level,
+                           uint8_t awake_GPIO, bool awake_level,
+                           uint8_t timeout)
 {
-    _Transmit(uart, "AT+UART_CUR?", timeout);
+    ESP8266_AT_Arg args[] = {{.u = enable}, {.u = trigger_gpio}, {.u = trigger_level},
+                             {.u = awake_GPIO}, {.u = awake_level}};
+
+    _Send(uart, ESP8266_AT_CMD_WAKEUPGPIO, ESP8266_AT_SET, args,
+          awake_GPIO == ESP8266_AT_NO_GPIO ? 3 : 5, timeout);
 }
 
-void ESP8266_AT_UART_CUR_SET(UART_HandleTypeDef *uart, uint8_t baudrate, uint8_t databits, uint8_t stopbits, uint8_t parity, uint8_t flow_control, uint8_t timeout)
+void ESP8266_AT_PING(UART_HandleTypeDef *uart, const char *host, uint8_t timeout)
 {
+    ESP8266_AT_Arg args[] = {{.s = host}};
+
+    _Send(uart, ESP8266_AT_CMD_PING, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_UART_DEF_QUERY(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_AT_RFPOWER(UART_HandleTypeDef *uart, uint8_t Tx_power, uint8_t timeout)
 {
-    _Transmit(uart, "AT+UART_DEF?", timeout);
+    ESP8266_AT_Arg args[] = {{.u = Tx_power > ESP8266_AT_RFPOWER_MAX ? ESP8266_AT_RFPOWER_MAX : Tx_power}};
+
+    _Send(uart, ESP8266_AT_CMD_RFPOWER, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_UART_DEF_SET(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_AT_RFVDD_SET(UART_HandleTypeDef *uart, uint16_t VD33, uint8_t timeout)
 {
+    if (VD33 < ESP8266_AT_VDD33_MIN)
+        VD33 = ESP8266_AT_VDD33_MIN;
+    if (VD33 > ESP8266_AT_VDD33_MAX)
+        VD33 = ESP8266_AT_VDD33_MAX;
+    ESP8266_AT_Arg args[] = {{.u = VD33}};
+
+    _Send(uart, ESP8266_AT_CMD_RFVDD, ESP8266_AT_SET, args, 1, timeout);
 }
 
-void ESP8266_AT_SLEEP_QUERY(UART_HandleTypeDef *uart, uint8_t timeout)
+void ESP8266_AT_SYSIOSETCFG(UART_HandleTypeDef *uart, uint8_t pin,
+                            uint8_t mode, bool pull_up, uint8_t timeout)
 {
-    _Transmit(uart, "AT+SLEEP?", timeout);
+    ESP8266_AT_Arg args[] = {{.u = pin}, {.u = mode}, {.u = pull_up}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSIOSETCFG, ESP8266_AT_SET, args, 3, timeout);
 }
 
-void ESP8266_AT_SLEEP_SET(UART_HandleTypeDef *uart, uint8_t sleep_mode, uint8_t timeout)
+void ESP8266_AT_SYSIOGETCFG(UART_HandleTypeDef *uart, uint8_t pin, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = pin}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSIOGETCFG, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_SYSGPIODIR(UART_HandleTypeDef *uart, uint8_t pin,
+                           bool dir, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = pin}, {.u = dir}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSGPIODIR, ESP8266_AT_SET, args, 2, timeout);
+}
+
+void ESP8266_AT_SYSGPIOWRITE(UART_HandleTypeDef *uart, uint8_t pin,
+                             bool level, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = pin}, {.u = level}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSGPIOWRITE, ESP8266_AT_SET, args, 2, timeout);
+}
+
+void ESP8266_AT_SYSGPIOREAD(UART_HandleTypeDef *uart, uint8_t pin, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = pin}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSGPIOREAD, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_SYSMSG_CUR(UART_HandleTypeDef *uart,
+                           bool set_quit_message,
+                           bool set_establish_message, uint8_t timeout)
+{
+    // bit 0: +QUITT, bit 1: +LINK_CONN
+    ESP8266_AT_Arg args[] = {{.u = set_quit_message | set_establish_message << 1}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSMSG_CUR, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_SYSMSG_DEF(UART_HandleTypeDef *uart,
+                           bool set_quit_message,
+                           bool set_establish_message, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = set_quit_message | set_establish_message << 1}};
+
+    _Send(uart, ESP8266_AT_CMD_SYSMSG_DEF, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_CWMODE_CUR_SET(UART_HandleTypeDef *uart, uint8_t mode, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = mode}};
+
+    _Send(uart, ESP8266_AT_CMD_CWMODE_CUR, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_CIPMUX_SET(UART_HandleTypeDef *uart, bool multiple, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = multiple}};
+
+    _Send(uart, ESP8266_AT_CMD_CIPMUX, ESP8266_AT_SET, args, 1, timeout);
+}
+
+void ESP8266_AT_CIPMODE_SET(UART_HandleTypeDef *uart, bool passthrough, uint8_t timeout)
+{
+    ESP8266_AT_Arg args[] = {{.u = passthrough}};
+
+    _Send(uart, ESP8266_AT_CMD_CIPMODE, ESP8266_AT_SET, args, 1, timeout);
+}
+
+uint16_t ESP8266_AT_Format(char *buf, size_t size, ESP8266_AT_CmdId id, uint8_t form,
+                           const ESP8266_AT_Arg *args, uint8_t count)
 {
+    if (id >= ESP8266_AT_CMD_OTHER || !(ESP8266_AT_Commands[id].forms & form))
+        return 0;
+
+    const ESP8266_AT_Command *cmd = &ESP8266_AT_Commands[id];
+    if (form == ESP8266_AT_SET ? count < cmd->required || count > cmd->param_count : count != 0)
+        return 0;
+    // the verb, '=' or '?' and the terminator
+    if (size < cmd->verb_len + 2U)
+        return 0;
+
+    memcpy(buf, cmd->verb, cmd->verb_len);
+    size_t len = cmd->verb_len;
+    if (form == ESP8266_AT_QUERY)
+        buf[len++] = '?';
+    else if (form == ESP8266_AT_SET && !(cmd->forms & ESP8266_AT_INLINE))
+        buf[len++] = '=';
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const ESP8266_AT_Param *param = &cmd->params[i];
+        // widest field: a quoted MAC address
+        char field[ESP8266_AT_MAC_CHARS + 2];
+        uint16_t n;
+
+        switch (param->type)
+        {
+        case ESP8266_AT_PARAM_UINT:
+            if (args[i].u < param->min || args[i].u > param->max)
+                return 0;
+            n = ESP8266_AT_FormatUint(field, args[i].u);
+            break;
+
+        case ESP8266_AT_PARAM_STRING:
+            if (args[i].s == NULL || strlen(args[i].s) > param->max)
+                return 0;
+            // written in place, it can be longer than field
+            n = ESP8266_AT_FormatQuoted(buf + len + (i > 0), size - len - (i > 0), args[i].s);
+            if (n == 0)
+                return 0;
+            break;
+
+        case ESP8266_AT_PARAM_IPV4:
+        case ESP8266_AT_PARAM_MAC:
+            if (args[i].bytes == NULL)
+                return 0;
+            field[0] = '"';
+            n = 1 + (param->type == ESP8266_AT_PARAM_IPV4 ? ESP8266_AT_FormatIPv4(field + 1, args[i].bytes)
+                                                          : ESP8266_AT_FormatMac(field + 1, args[i].bytes));
+            field[n++] = '"';
+            break;
+
+        default:
+            return 0;
+        }
+
+        // the separator, the field and the terminator
+        if (len + (i > 0) + n >= size)
+            return 0;
+        if (i > 0)
+            buf[len++] = ',';
+        if (param->type != ESP8266_AT_PARAM_STRING)
+            memcpy(buf + len, field, n);
+        len += n;
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
+int8_t ESP8266_AT_ParseReply(ESP8266_AT_CmdId id, const char *line, int32_t *values, uint8_t max)
+{
+    if (id >= ESP8266_AT_CMD_OTHER)
+        return -1;
+
+    const ESP8266_AT_Command *cmd = &ESP8266_AT_Commands[id];
+    if (cmd->reply_len == 0 || strncmp(line, cmd->reply, cmd->reply_len) != 0)
+        return -1;
+
+    const char *p = line + cmd->reply_len;
+    int8_t n = 0;
+    while (n < max)
+    {
+        const char *end;
+
+        values[n] = 0;
+        if (*p == '"')
+            end = ESP8266_AT_ParseQuoted(p, NULL, 0);
+        else
+            end = ESP8266_AT_ParseInt(p, &values[n]);
+        if (end == NULL)
+            break;
+
+        n++;
+        p = end;
+        if (*p != ',')
+            break;
+        p++;
+    }
+
+    return n;
+}
+
+uint32_t ESP8266_AT_MaxBaud(UART_HandleTypeDef *uart)
+{
+    static const uint32_t rates[] = {4608000, 3686400, 2000000, 1843200, 921600, 460800, 230400, 115200};
+
+    uint32_t pclk = uart->Instance == USART1 || uart->Instance == USART6 ? HAL_RCC_GetPCLK2Freq()
+                                                                         : HAL_RCC_GetPCLK1Freq();
+    uint32_t oversampling = uart->Init.OverSampling == UART_OVERSAMPLING_8 ? 8 : 16;
+
+    for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        // BRR holds pclk / baud rounded, in 1/oversampling steps of USARTDIV
+        uint32_t div = (pclk + rates[i] / 2) / rates[i];
+        if (div < oversampling)
+            continue;
+
+        uint32_t actual = pclk / div;
+        uint32_t error = actual > rates[i] ? actual - rates[i] : rates[i] - actual;
+        if ((uint64_t)error * 1000 <= (uint64_t)rates[i] * ESP8266_AT_BAUD_TOLERANCE_PERMILLE)
+            return rates[i];
+    }
+
+    return 0;
+}
+
+ESP8266_AT_CmdId ESP8266_AT_CommandId(const char *cmd)
+{
+    size_t len = strcspn(cmd, "=?\r\n");
+    // ATE0/ATE1 carry their argument without '='
+    if (len == 4 && strncmp(cmd, "ATE", 3) == 0)
+        len = 3;
+
+    for (uint8_t id = 0; id < ESP8266_AT_CMD_OTHER; id++)
+    {
+        if (ESP8266_AT_Commands[id].verb_len == len && strncmp(cmd, ESP8266_AT_Commands[id].verb, len) == 0)
+            return (ESP8266_AT_CmdId)id;
+    }
+
+    return ESP8266_AT_CMD_OTHER;
 }
@@ -0,0 +1,645 @@
+#include "ESP8266_AT_Async.h"
+#include "ESP8266_AT_Boot.h"
+#include "ESP8266_AT_Capture.h"
+#include "ESP8266_AT_Config.h"
+#include "ESP8266_AT_Gpio.h"
+#include "ESP8266_AT_HeapWatch.h"
+#include "ESP8266_AT_Keyword.h"
+#include "ESP8266_AT_Metrics.h"
+#include "ESP8266_AT_Pool.h"
+#include "ESP8266_AT_Prof.h"
+#include "ESP8266_AT_Scan.h"
+#include "ESP8266_AT_Trace.h"
+#include "ESP8266_AT_Tx.h"
+#include "ESP8266_AT_TxPower.h"
+
+#include <stdlib.h>
+
+typedef struct
+{
+    char cmd[ESP8266_AT_ASYNC_CMD_LEN];
+    uint16_t len;
+    ESP8266_AT_CmdId id;
+    uint8_t form;  // 0 for raw command lines
+    uint8_t count; // arguments kept for the config cache
+    ESP8266_AT_Arg args[ESP8266_AT_CONFIG_VALUES];
+    uint32_t timeout;
+    uint32_t queued_at;
+    ESP8266_AT_LineHandler on_line;
+    ESP8266_AT_DoneHandler on_done;
+    void *ctx;
+} ESP8266_AT_AsyncCmd;
+
+static UART_HandleTypeDef *esp_uart;
+
+ESP8266_AT_POOL(cmd_pool, ESP8266_AT_AsyncCmd, ESP8266_AT_ASYNC_QUEUE_LEN);
+
+typedef struct
+{
+    ESP8266_AT_AsyncCmd *cmds[ESP8266_AT_ASYNC_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+} ESP8266_AT_Lane;
+
+static ESP8266_AT_Lane lanes[ESP8266_AT_PRIO_COUNT];
+static uint8_t lane;        // lane of the command in flight
+static uint8_t queue_count; // commands in all lanes
+static ESP8266_AT_WaitStats waits[ESP8266_AT_PRIO_COUNT];
+static bool in_flight;
+static bool payload_open; // CIPSEND answered, SEND OK still to come
+static bool payload_prompt; // '>' received: the module is reading the payload
+static ESP8266_AT_Result payload_result;
+static uint32_t payload_at;
+static bool held;
+static uint32_t sent_at;
+static volatile bool awaiting_first_byte;
+
+static uint8_t rx_ring[ESP8266_AT_ASYNC_RX_LEN];
+static volatile uint16_t rx_head;
+static uint16_t rx_tail;
+static uint8_t rx_byte;
+
+static char line[ESP8266_AT_ASYNC_LINE_LEN];
+static uint16_t line_len;
+static bool line_overflow;
+
+// the highest lane holding a command
+ESP8266_AT_RAMFUNC static inline uint8_t _Next(void)
+{
+    uint8_t next = ESP8266_AT_PRIO_COUNT - 1;
+    while (next > 0 && lanes[next].count == 0)
+        next--;
+
+    return next;
+}
+
+// the command in flight, else the one to send next
+ESP8266_AT_RAMFUNC static inline ESP8266_AT_AsyncCmd *_Head(void)
+{
+    ESP8266_AT_Lane *from = &lanes[in_flight ? lane : _Next()];
+
+    return from->cmds[from->head];
+}
+
+static void _Waited(const ESP8266_AT_AsyncCmd *cmd)
+{
+    uint32_t waited = HAL_GetTick() - cmd->queued_at;
+
+    waits[lane].commands++;
+    waits[lane].total_ms += waited;
+    if (waited > waits[lane].max_ms)
+        waits[lane].max_ms = waited;
+}
+
+ESP8266_AT_RAMFUNC static inline void _ClosePayload(ESP8266_AT_Result result)
+{
+    if (!payload_open)
+        return;
+
+    payload_open = false;
+    payload_prompt = false;
+    payload_result = result;
+}
+
+// completes the head of the lane in <lane>
+static void _Complete(ESP8266_AT_Result result)
+{
+    ESP8266_AT_Lane *from = &lanes[lane];
+    ESP8266_AT_AsyncCmd *cmd = from->cmds[from->head];
+    ESP8266_AT_DoneHandler on_done = cmd->on_done;
+    void *ctx = cmd->ctx;
+
+    if (in_flight)
+    {
+        ESP8266_AT_Config_Done(cmd->id, cmd->form, cmd->args, cmd->count, result == ESP8266_AT_OK);
+        ESP8266_PROF_MARK(ESP8266_PROF_RESULT, cmd->id);
+        ESP8266_Metrics_Done(cmd->id, result, HAL_GetTick() - sent_at);
+    }
+    ESP8266_TRACE(ESP8266_TRACE_RESULT, cmd->id, NULL, result);
+
+    // the module restarts right after acknowledging these
+    if (in_flight && result == ESP8266_AT_OK &&
+        (cmd->id == ESP8266_AT_CMD_RST || cmd->id == ESP8266_AT_CMD_RESTORE))
+        ESP8266_AT_Boot_Start();
+    // and after this one once the sleep time is over
+    if (in_flight && result == ESP8266_AT_OK && cmd->id == ESP8266_AT_CMD_GSLP)
+    {
+        // "AT+GSLP=<ms>", raw or formatted
+        const char *sleep_ms = cmd->cmd + ESP8266_AT_Commands[cmd->id].verb_len + 1;
+        ESP8266_AT_Boot_Expect(strtoul(sleep_ms, NULL, 10));
+    }
+    // the module now takes whatever arrives as payload, unless it refused
+    if (cmd->id == ESP8266_AT_CMD_CIPSEND || cmd->id == ESP8266_AT_CMD_CIPSEND_MUX)
+    {
+        payload_open = in_flight && result == ESP8266_AT_OK;
+        payload_prompt = false;
+        payload_result = payload_open ? ESP8266_AT_PENDING : ESP8266_AT_ERROR;
+        payload_at = HAL_GetTick();
+    }
+
+    // free the slot before the callback so it can submit a follow-up
+    ESP8266_AT_Pool_Free(&cmd_pool, cmd);
+    from->head = (from->head + 1) % ESP8266_AT_ASYNC_QUEUE_LEN;
+    from->count--;
+    queue_count--;
+    in_flight = false;
+
+    if (on_done)
+        on_done(result, ctx);
+}
+
+// answers a command from the config cache as the module would have
+static void _Local(ESP8266_AT_AsyncCmd *cmd)
+{
+    if (cmd->form == ESP8266_AT_QUERY && cmd->on_line)
+    {
+        char reply[ESP8266_AT_LINE_MAX];
+        if (ESP8266_AT_Config_Reply(cmd->id, reply, sizeof(reply)))
+            cmd->on_line(reply, cmd->ctx);
+    }
+
+    _Complete(ESP8266_AT_OK);
+}
+
+// the module has lost every setting not saved to its flash
+static void _Restarted(void)
+{
+    ESP8266_AT_Config_Invalidate();
+    ESP8266_TxPower_Invalidate();
+    ESP8266_Gpio_Invalidate();
+    ESP8266_HeapWatch_Invalidate();
+}
+
+ESP8266_AT_RAMFUNC static void _Dispatch(const char *text, uint16_t len)
+{
+    ESP8266_AT_KeywordId keyword = ESP8266_AT_Keyword_Match(text, len);
+
+    // busy p... / busy s...: the module is still working on something
+    if (keyword == ESP8266_AT_KW_BUSY_P || keyword == ESP8266_AT_KW_BUSY_S)
+        ESP8266_Metrics_Busy();
+    // the module has restarted, whether asked to or not
+    else if (keyword == ESP8266_AT_KW_READY)
+    {
+        _Restarted();
+        _ClosePayload(ESP8266_AT_ERROR);
+    }
+    // the module's verdict on a CIPSEND payload
+    else if (keyword == ESP8266_AT_KW_SEND_OK)
+        _ClosePayload(ESP8266_AT_OK);
+    else if (keyword == ESP8266_AT_KW_SEND_FAIL)
+        _ClosePayload(ESP8266_AT_ERROR);
+
+    if (!in_flight)
+    {
+        ESP8266_TRACE(ESP8266_TRACE_URC, ESP8266_AT_CMD_OTHER, text, len);
+        return;
+    }
+
+    ESP8266_AT_AsyncCmd *cmd = _Head();
+    ESP8266_TRACE(ESP8266_TRACE_RX, cmd->id, text, len);
+    if (keyword == ESP8266_AT_KW_OK)
+        _Complete(ESP8266_AT_OK);
+    else if (keyword == ESP8266_AT_KW_ERROR || keyword == ESP8266_AT_KW_FAIL)
+        _Complete(ESP8266_AT_ERROR);
+    else
+    {
+        if (cmd->form == ESP8266_AT_QUERY)
+            ESP8266_AT_Config_Line(cmd->id, text);
+        if (cmd->on_line)
+            cmd->on_line(text, cmd->ctx);
+    }
+}
+
+bool ESP8266_AT_Async_Init(UART_HandleTypeDef *uart)
+{
+    esp_uart = uart;
+    ESP8266_AT_Pool_Init(&cmd_pool);
+    memset(lanes, 0, sizeof(lanes));
+    memset(waits, 0, sizeof(waits));
+    queue_count = 0;
+    in_flight = false;
+    payload_open = false;
+    payload_prompt = false;
+    payload_result = ESP8266_AT_ERROR;
+    held = false;
+    rx_head = 0;
+    rx_tail = 0;
+    line_len = 0;
+    line_overflow = false;
+    ESP8266_AT_Tx_Init(uart);
+
+    // with a keyword collision, lines would be matched to the wrong one
+    if (!ESP8266_AT_Keyword_Init())
+        return false;
+
+    HAL_UART_Receive_IT(esp_uart, &rx_byte, 1);
+    return true;
+}
+
+static bool _Full(ESP8266_AT_Priority prio)
+{
+    uint8_t limit = ESP8266_AT_ASYNC_QUEUE_LEN;
+    if (prio < ESP8266_AT_PRIO_HIGH)
+        limit -= ESP8266_AT_ASYNC_HIGH_RESERVE;
+
+    return queue_count >= limit;
+}
+
+static void _Queue(ESP8266_AT_Priority prio, ESP8266_AT_AsyncCmd *slot, uint16_t len,
+                   ESP8266_AT_CmdId id, uint32_t timeout, ESP8266_AT_LineHandler on_line,
+                   ESP8266_AT_DoneHandler on_done, void *ctx)
+{
+    ESP8266_AT_Lane *to = &lanes[prio];
+
+    slot->cmd[len] = '\r';
+    slot->cmd[len + 1] = '\n';
+    slot->len = len + 2;
+    slot->id = id;
+    slot->timeout = timeout;
+    slot->on_line = on_line;
+    slot->on_done = on_done;
+    slot->ctx = ctx;
+    slot->queued_at = HAL_GetTick();
+    to->cmds[(to->head + to->count) % ESP8266_AT_ASYNC_QUEUE_LEN] = slot;
+    to->count++;
+    queue_count++;
+
+    ESP8266_PROF_MARK(ESP8266_PROF_FORMAT_END, id);
+}
+
+bool ESP8266_AT_Async_Submit(const char *cmd, uint32_t timeout,
+                             ESP8266_AT_LineHandler on_line,
+                             ESP8266_AT_DoneHandler on_done, void *ctx)
+{
+    ESP8266_PROF_MARK(ESP8266_PROF_FORMAT_BEGIN, ESP8266_AT_CMD_OTHER);
+    size_t len = strlen(cmd);
+
+    if (_Full(ESP8266_AT_PRIO_NORMAL) || len + 2 > ESP8266_AT_ASYNC_CMD_LEN)
+        return false;
+
+    ESP8266_AT_AsyncCmd *slot = ESP8266_AT_Pool_Alloc(&cmd_pool);
+    if (slot == NULL)
+        return false;
+    memcpy(slot->cmd, cmd, len);
+    slot->form = 0;
+    slot->count = 0;
+    _Queue(ESP8266_AT_PRIO_NORMAL, slot, len, ESP8266_AT_CommandId(cmd), timeout,
+           on_line, on_done, ctx);
+
+    return true;
+}
+
+bool ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CmdId id, uint8_t form,
+                                const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                ESP8266_AT_LineHandler on_line,
+                                ESP8266_AT_DoneHandler on_done, void *ctx)
+{
+    return ESP8266_AT_Async_SubmitPrio(ESP8266_AT_PRIO_NORMAL, id, form, args, count, timeout,
+                                       on_line, on_done, ctx);
+}
+
+bool ESP8266_AT_Async_SubmitPrio(ESP8266_AT_Priority prio, ESP8266_AT_CmdId id, uint8_t form,
+                                 const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                 ESP8266_AT_LineHandler on_line,
+                                 ESP8266_AT_DoneHandler on_done, void *ctx)
+{
+    ESP8266_PROF_MARK(ESP8266_PROF_FORMAT_BEGIN, id);
+
+    if (prio >= ESP8266_AT_PRIO_COUNT || _Full(prio))
+        return false;
+
+    ESP8266_AT_AsyncCmd *slot = ESP8266_AT_Pool_Alloc(&cmd_pool);
+    if (slot == NULL)
+        return false;
+
+    // leave room for CR/LF after the terminator Format writes
+    uint16_t len = ESP8266_AT_Format(slot->cmd, ESP8266_AT_ASYNC_CMD_LEN - 1, id, form, args, count);
+    if (len == 0)
+    {
+        ESP8266_AT_Pool_Free(&cmd_pool, slot);
+        return false;
+    }
+
+    slot->form = form;
+    slot->count = 0;
+    if (form == ESP8266_AT_SET && ESP8266_AT_Config_Tracked(id) && count <= ESP8266_AT_CONFIG_VALUES)
+    {
+        memcpy(slot->args, args, count * sizeof(ESP8266_AT_Arg));
+        slot->count = count;
+    }
+
+    _Queue(prio, slot, len, id, timeout ? timeout : ESP8266_AT_Commands[id].timeout,
+           on_line, on_done, ctx);
+
+    return true;
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_AT_Async_Poll(void)
+{
+    uint32_t parse_start = ESP8266_PROF_NOW();
+    uint32_t parsed = 0;
+
+    // bytes committed while the UART was busy elsewhere
+    ESP8266_AT_Tx_Kick();
+
+    if (rx_tail != rx_head)
+        ESP8266_AT_Boot_Received();
+
+    while (rx_tail != rx_head)
+    {
+        // search the contiguous part of the ring for the end of line
+        uint16_t head = rx_head;
+        uint16_t run = (head > rx_tail ? head : ESP8266_AT_ASYNC_RX_LEN) - rx_tail;
+        const uint8_t *start = &rx_ring[rx_tail];
+        uint16_t text = ESP8266_AT_Scan(start, run, '\n');
+        bool found = text < run;
+
+        if (text > ESP8266_AT_ASYNC_LINE_LEN - 1 - line_len)
+        {
+            memcpy(line + line_len, start, ESP8266_AT_ASYNC_LINE_LEN - 1 - line_len);
+            line_len = ESP8266_AT_ASYNC_LINE_LEN - 1;
+            line_overflow = true;
+        }
+        else
+        {
+            memcpy(line + line_len, start, text);
+            line_len += text;
+        }
+
+        parsed += text + found;
+        rx_tail = (rx_tail + text + found) & (ESP8266_AT_ASYNC_RX_LEN - 1);
+
+        if (found)
+        {
+            if (line_len > 0 && line[line_len - 1] == '\r')
+                line_len--;
+            line[line_len] = '\0';
+
+            if (ESP8266_AT_Boot_Line(line, line_len, line_overflow))
+                ESP8266_TRACE(ESP8266_TRACE_DROP, ESP8266_AT_CMD_OTHER, line, line_len);
+            else if (line_overflow)
+            {
+                ESP8266_Metrics_Resync();
+                ESP8266_TRACE(ESP8266_TRACE_DROP, ESP8266_AT_CMD_OTHER, line, line_len);
+            }
+            else if (line_len > 0)
+                _Dispatch(line, line_len);
+
+            line_len = 0;
+            line_overflow = false;
+        }
+    }
+    ESP8266_PROF_PARSE(ESP8266_PROF_NOW() - parse_start, parsed);
+
+    // "> " asks for the payload and is never followed by a line end
+    if (payload_open && line_len > 0 && line[0] == '>')
+    {
+        payload_prompt = true;
+        line_len = 0;
+    }
+
+    if (in_flight && HAL_GetTick() - sent_at > _Head()->timeout)
+        _Complete(ESP8266_AT_TIMEOUT);
+    // the payload was never completed: the module gives up on it too
+    if (payload_open && HAL_GetTick() - payload_at > ESP8266_AT_ASYNC_PAYLOAD_TIMEOUT)
+        _ClosePayload(ESP8266_AT_TIMEOUT);
+
+    // only between transactions, so a higher lane never cuts into one
+    while (!in_flight && !held && !payload_open && queue_count > 0 && ESP8266_AT_Boot_Ready())
+    {
+        lane = _Next();
+        ESP8266_AT_AsyncCmd *cmd = _Head();
+        if (cmd->form && ESP8266_AT_Config_Current(cmd->id, cmd->form, cmd->args, cmd->count))
+        {
+            _Waited(cmd);
+            _Local(cmd);
+            continue;
+        }
+
+        // queued behind any payload still draining from the other buffer
+        uint8_t *room = ESP8266_AT_Tx_Reserve(cmd->len);
+        if (room == NULL)
+            break;
+
+        _Waited(cmd);
+        ESP8266_PROF_MARK(ESP8266_PROF_TX_START, cmd->id);
+        awaiting_first_byte = true;
+        memcpy(room, cmd->cmd, cmd->len);
+        ESP8266_AT_Tx_Commit(cmd->len);
+        if (cmd->form)
+            ESP8266_AT_Config_Sent(cmd->id, cmd->form);
+        else
+            ESP8266_AT_Config_SentLine(cmd->cmd);
+        in_flight = true;
+        sent_at = HAL_GetTick();
+        ESP8266_Metrics_Sent(cmd->id, cmd->len);
+        ESP8266_TRACE(ESP8266_TRACE_TX, cmd->id, cmd->cmd, cmd->len);
+    }
+}
+
+bool ESP8266_AT_Async_Idle(void)
+{
+    return queue_count == 0;
+}
+
+bool ESP8266_AT_Async_WorkPending(void)
+{
+    if (rx_tail != rx_head)
+        return true;
+
+    return !in_flight && !held && !payload_open && queue_count > 0 && ESP8266_AT_Boot_Ready() &&
+           ESP8266_AT_Tx_Room() >= _Head()->len;
+}
+
+bool ESP8266_AT_Async_Quiet(void)
+{
+    // a boot in progress or an open payload needs the tick to time out
+    return !in_flight && !payload_open && (held || queue_count == 0) && rx_tail == rx_head && !ESP8266_AT_Tx_Busy() &&
+           ESP8266_AT_Boot_Ready() && esp_uart->gState == HAL_UART_STATE_READY;
+}
+
+bool ESP8266_AT_Async_PayloadReady(void)
+{
+    return payload_prompt;
+}
+
+ESP8266_AT_Result ESP8266_AT_Async_PayloadResult(void)
+{
+    return payload_result;
+}
+
+uint16_t ESP8266_AT_Async_Write(const void *data, uint16_t len)
+{
+    uint16_t written = ESP8266_AT_Tx_Write(data, len);
+
+    ESP8266_Metrics_Payload(written);
+    ESP8266_TRACE(ESP8266_TRACE_TX, ESP8266_AT_CMD_OTHER, (const char *)data, written);
+
+    return written;
+}
+
+void ESP8266_AT_Async_SlotStats(ESP8266_AT_PoolStats *stats)
+{
+    ESP8266_AT_Pool_GetStats(&cmd_pool, stats);
+}
+
+void ESP8266_AT_Async_WaitStats(ESP8266_AT_Priority prio, ESP8266_AT_WaitStats *stats)
+{
+    *stats = waits[prio];
+}
+
+void ESP8266_AT_Async_Hold(bool hold)
+{
+    held = hold;
+}
+
+void ESP8266_AT_Async_Reset(void)
+{
+    _Restarted();
+    ESP8266_AT_Boot_Start();
+    rx_tail = rx_head;
+    line_len = 0;
+    line_overflow = false;
+
+    ESP8266_AT_Async_Abort();
+}
+
+void ESP8266_AT_Async_Abort(void)
+{
+    ESP8266_AT_Tx_Abort();
+    _ClosePayload(ESP8266_AT_ERROR);
+
+    // commands submitted from the callbacks survive the reset
+    uint8_t pending[ESP8266_AT_PRIO_COUNT];
+    for (uint8_t prio = 0; prio < ESP8266_AT_PRIO_COUNT; prio++)
+        pending[prio] = lanes[prio].count;
+    if (in_flight)
+    {
+        pending[lane]--;
+        _Complete(ESP8266_AT_ERROR);
+    }
+    for (uint8_t prio = 0; prio < ESP8266_AT_PRIO_COUNT; prio++)
+        for (; pending[prio] > 0; pending[prio]--)
+        {
+            lane = prio;
+            _Complete(ESP8266_AT_ERROR);
+        }
+}
+
+bool ESP8266_AT_Async_Reclock(void)
+{
+    uint32_t start = HAL_GetTick();
+    bool drained = true;
+
+    while (ESP8266_AT_Tx_Busy() || esp_uart->gState != HAL_UART_STATE_READY)
+    {
+        // a stuck transfer would otherwise go out at the wrong rate
+        if (HAL_GetTick() - start >= ESP8266_AT_ASYNC_RECLOCK_TIMEOUT)
+        {
+            ESP8266_AT_Tx_Abort();
+            drained = false;
+            break;
+        }
+        ESP8266_AT_Tx_Kick();
+    }
+
+    HAL_UART_AbortReceive(esp_uart);
+    HAL_UART_Init(esp_uart);
+    HAL_UART_Receive_IT(esp_uart, &rx_byte, 1);
+
+    return drained;
+}
+
+uint16_t ESP8266_AT_Async_Feed(const uint8_t *data, uint16_t len)
+{
+    uint16_t fed = 0;
+
+    // the receive interrupt writes rx_head too
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    while (fed < len)
+    {
+        uint16_t next = (rx_head + 1) & (ESP8266_AT_ASYNC_RX_LEN - 1);
+        if (next == rx_tail)
+            break;
+
+        rx_ring[rx_head] = data[fed++];
+        rx_head = next;
+    }
+    __set_PRIMASK(primask);
+
+    return fed;
+}
+
+void ESP8266_AT_Async_TxCpltCallback(UART_HandleTypeDef *uart)
+{
+    if (uart != esp_uart)
+        return;
+
+    ESP8266_AT_Tx_CpltCallback(uart);
+    if (!ESP8266_AT_Tx_Busy() && queue_count > 0)
+        ESP8266_PROF_MARK(ESP8266_PROF_TX_DONE, _Head()->id);
+}
+
+ESP8266_AT_RAMFUNC static void _Receive(uint8_t byte)
+{
+    ESP8266_PROF_MARK(ESP8266_PROF_ISR_ENTER, ESP8266_AT_CMD_OTHER);
+    if (awaiting_first_byte && in_flight)
+    {
+        ESP8266_PROF_MARK(ESP8266_PROF_FIRST_BYTE, _Head()->id);
+        awaiting_first_byte = false;
+    }
+
+    uint16_t next = (rx_head + 1) & (ESP8266_AT_ASYNC_RX_LEN - 1);
+    if (next != rx_tail)
+    {
+        rx_ring[rx_head] = byte;
+        rx_head = next;
+    }
+    else
+        ESP8266_Metrics_Overrun();
+    ESP8266_Metrics_Received();
+    ESP8266_CAPTURE_BYTE(byte);
+}
+
+ESP8266_AT_RAMFUNC bool ESP8266_AT_Async_IRQHandler(UART_HandleTypeDef *uart)
+{
+    if (uart != esp_uart)
+        return false;
+
+    USART_TypeDef *regs = uart->Instance;
+    uint32_t sr = regs->SR;
+    uint32_t cr1 = regs->CR1;
+
+    // errors, and bytes while reception is not armed, stay with the HAL
+    if (!(sr & USART_SR_RXNE) || (sr & (USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE)) ||
+        uart->RxState != HAL_UART_STATE_BUSY_RX)
+        return false;
+
+    // reading DR clears RXNE. Reception stays armed for the next byte
+    _Receive((uint8_t)regs->DR);
+    ESP8266_PROF_MARK(ESP8266_PROF_ISR_EXIT, ESP8266_AT_CMD_OTHER);
+
+    return !((cr1 & USART_CR1_TXEIE) && (sr & USART_SR_TXE)) && !((cr1 & USART_CR1_TCIE) && (sr & USART_SR_TC));
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_AT_Async_RxCpltCallback(UART_HandleTypeDef *uart)
+{
+    if (uart != esp_uart)
+        return;
+
+    _Receive(rx_byte);
+    HAL_UART_Receive_IT(esp_uart, &rx_byte, 1);
+    ESP8266_PROF_MARK(ESP8266_PROF_ISR_EXIT, ESP8266_AT_CMD_OTHER);
+}
+
+void ESP8266_AT_Async_ErrorCallback(UART_HandleTypeDef *uart)
+{
+    if (uart != esp_uart)
+        return;
+
+    if (uart->ErrorCode & HAL_UART_ERROR_ORE)
+        ESP8266_Metrics_Overrun();
+
+    HAL_UART_Receive_IT(esp_uart, &rx_byte, 1);
+}
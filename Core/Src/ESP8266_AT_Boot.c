@@ -0,0 +1,108 @@
+#include "ESP8266_AT_Boot.h"
+
+#define BANNER "ready"
+#define BANNER_LEN (sizeof(BANNER) - 1)
+
+static ESP8266_AT_BootPhase phase;
+static uint32_t started_at; // when the boot is due, possibly ahead
+static ESP8266_AT_BootStats stats;
+
+static bool _Booting(void)
+{
+    return phase == ESP8266_AT_BOOT_RESET || phase == ESP8266_AT_BOOT_ROM ||
+           phase == ESP8266_AT_BOOT_FIRMWARE;
+}
+
+// ms since the boot was due, negative before
+static int32_t _Elapsed(void)
+{
+    return (int32_t)(HAL_GetTick() - started_at);
+}
+
+// ROM output at 74880 baud decodes to control and high bytes
+static bool _Clean(const char *line, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        if ((uint8_t)line[i] < ' ' || (uint8_t)line[i] > '~')
+            return false;
+
+    return len > 0;
+}
+
+void ESP8266_AT_Boot_Start(void)
+{
+    ESP8266_AT_Boot_Expect(0);
+}
+
+void ESP8266_AT_Boot_Expect(uint32_t delay_ms)
+{
+    phase = ESP8266_AT_BOOT_RESET;
+    started_at = HAL_GetTick() + delay_ms;
+    stats.boots++;
+    stats.rom_ms = 0;
+    stats.firmware_ms = 0;
+    stats.ready_ms = 0;
+}
+
+void ESP8266_AT_Boot_Received(void)
+{
+    // a module going to sleep may still send a byte or two
+    if (phase != ESP8266_AT_BOOT_RESET || _Elapsed() < 0)
+        return;
+
+    phase = ESP8266_AT_BOOT_ROM;
+    stats.rom_ms = _Elapsed();
+}
+
+bool ESP8266_AT_Boot_Line(const char *line, uint16_t len, bool overflow)
+{
+    bool banner = !overflow && len >= BANNER_LEN &&
+                  memcmp(line + len - BANNER_LEN, BANNER, BANNER_LEN) == 0;
+
+    // a late banner still completes the boot timing
+    if (banner && (_Booting() || phase == ESP8266_AT_BOOT_TIMEOUT))
+    {
+        phase = ESP8266_AT_BOOT_DONE;
+        stats.ready_ms = _Elapsed() > 0 ? _Elapsed() : 0;
+        return false;
+    }
+
+    if (!_Booting())
+    {
+        if (banner && len == BANNER_LEN)
+            stats.unexpected++;
+        return false;
+    }
+
+    if (phase != ESP8266_AT_BOOT_FIRMWARE && !overflow && _Clean(line, len))
+    {
+        phase = ESP8266_AT_BOOT_FIRMWARE;
+        stats.firmware_ms = _Elapsed() > 0 ? _Elapsed() : 0;
+    }
+    stats.dropped_lines++;
+
+    return true;
+}
+
+bool ESP8266_AT_Boot_Ready(void)
+{
+    if (!_Booting())
+        return true;
+
+    if (_Elapsed() < ESP8266_AT_BOOT_TIMEOUT_MS)
+        return false;
+
+    phase = ESP8266_AT_BOOT_TIMEOUT;
+    stats.timeouts++;
+    return true;
+}
+
+ESP8266_AT_BootPhase ESP8266_AT_Boot_Phase(void)
+{
+    return phase;
+}
+
+void ESP8266_AT_Boot_GetStats(ESP8266_AT_BootStats *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,162 @@
+#include "ESP8266_AT_Capture.h"
+
+static void _CycleCounterOn(void)
+{
+#if defined(__ARM_ARCH)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+#ifdef ESP8266_AT_CAPTURE
+
+static uint8_t capture[ESP8266_CAPTURE_LEN];
+static size_t capture_len;
+static uint32_t last_byte;
+static uint32_t last_ms; // HAL_GetTick of last_byte, for gaps the counter cannot span
+static volatile bool recording;
+
+void ESP8266_Capture_Start(uint32_t baud)
+{
+    recording = false;
+    _CycleCounterOn();
+
+    capture[0] = 'C';
+    capture[1] = ESP8266_CAPTURE_VERSION;
+    capture[2] = 0;
+    capture[3] = 0;
+    memcpy(capture + 4, &baud, 4);
+    capture_len = ESP8266_CAPTURE_HEADER_LEN;
+
+    last_byte = ESP8266_CAPTURE_NOW();
+    last_ms = HAL_GetTick();
+    recording = true;
+}
+
+void ESP8266_Capture_Stop(void)
+{
+    recording = false;
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_Capture_Byte(uint8_t byte)
+{
+    if (!recording)
+        return;
+
+    uint32_t now = ESP8266_CAPTURE_NOW();
+    uint32_t now_ms = HAL_GetTick();
+    uint32_t delay = (now - last_byte) / ESP8266_CAPTURE_TICKS_PER_US();
+
+    // the cycle counter wraps every 2^32 ticks, 23.9 s at 180 MHz; past
+    // a second the tick is precise enough and does not wrap for 49 days
+    uint32_t gap_ms = now_ms - last_ms;
+    if (gap_ms >= ESP8266_CAPTURE_LONG_GAP_MS)
+        delay = gap_ms < UINT32_MAX / 1000 ? gap_ms * 1000 : UINT32_MAX;
+    last_byte = now;
+    last_ms = now_ms;
+
+    // worst case: 5 varint bytes and the data byte
+    if (capture_len + 6 > ESP8266_CAPTURE_LEN)
+    {
+        recording = false;
+        return;
+    }
+
+    do
+    {
+        capture[capture_len++] = (delay & 0x7F) | (delay > 0x7F ? 0x80 : 0);
+        delay >>= 7;
+    } while (delay);
+    capture[capture_len++] = byte;
+}
+
+const uint8_t *ESP8266_Capture_Data(size_t *len)
+{
+    *len = capture_len;
+    return capture;
+}
+
+#endif
+
+// waits in steps of ESP8266_CAPTURE_LONG_GAP_MS at most, so neither
+// <due> nor the signed comparison overflows on long gaps
+static void _Wait(uint32_t *due, uint32_t delay_us, uint32_t ticks_per_us)
+{
+    while (delay_us > 0)
+    {
+        uint32_t step = delay_us < ESP8266_CAPTURE_LONG_GAP_MS * 1000
+                            ? delay_us
+                            : ESP8266_CAPTURE_LONG_GAP_MS * 1000;
+        *due += step * ticks_per_us;
+        delay_us -= step;
+        while ((int32_t)(ESP8266_CAPTURE_NOW() - *due) < 0)
+            ESP8266_AT_Async_Poll();
+    }
+}
+
+static void _Push(const uint8_t *bytes, uint16_t count, ESP8266_ReplayStats *stats)
+{
+    uint16_t fed = ESP8266_AT_Async_Feed(bytes, count);
+    if (fed < count)
+    {
+        // the ring is full; drain it and retry once
+        ESP8266_AT_Async_Poll();
+        fed += ESP8266_AT_Async_Feed(bytes + fed, count - fed);
+    }
+
+    stats->bytes += count;
+    stats->dropped += count - fed;
+    ESP8266_AT_Async_Poll();
+}
+
+bool ESP8266_Capture_Replay(const uint8_t *data, size_t len, bool real_time,
+                            ESP8266_ReplayStats *stats)
+{
+    if (len < ESP8266_CAPTURE_HEADER_LEN || data[0] != 'C' || data[1] != ESP8266_CAPTURE_VERSION)
+        return false;
+
+    _CycleCounterOn();
+    memset(stats, 0, sizeof(*stats));
+
+    uint8_t batch[32];
+    uint16_t batched = 0;
+    uint32_t ticks_per_us = ESP8266_CAPTURE_TICKS_PER_US();
+    uint32_t start = ESP8266_CAPTURE_NOW();
+    uint32_t due = start;
+    size_t pos = ESP8266_CAPTURE_HEADER_LEN;
+
+    while (pos < len)
+    {
+        uint32_t delay = 0;
+        uint8_t shift = 0;
+        while (pos < len && (data[pos] & 0x80))
+        {
+            delay |= (uint32_t)(data[pos++] & 0x7F) << shift;
+            shift += 7;
+        }
+        if (pos + 1 >= len)
+            break;
+        delay |= (uint32_t)data[pos++] << shift;
+
+        if (real_time)
+        {
+            _Wait(&due, delay, ticks_per_us);
+            _Push(&data[pos++], 1, stats);
+            continue;
+        }
+
+        // flat out, bytes go in batches as they would from a DMA burst
+        batch[batched++] = data[pos++];
+        if (batched == sizeof(batch))
+        {
+            _Push(batch, batched, stats);
+            batched = 0;
+        }
+    }
+
+    if (batched)
+        _Push(batch, batched, stats);
+    stats->cycles = ESP8266_CAPTURE_NOW() - start;
+
+    return true;
+}
@@ -0,0 +1,235 @@
+#include "ESP8266_AT_Config.h"
+#include "ESP8266_AT_Defaults.h"
+#include "ESP8266_AT_Text.h"
+
+typedef enum
+{
+#define C(name) CONFIG_##name,
+    ESP8266_AT_CONFIG(C)
+#undef C
+    CONFIG_COUNT,
+    CONFIG_NONE = CONFIG_COUNT
+} ConfigIndex;
+
+typedef struct
+{
+    int32_t values[ESP8266_AT_CONFIG_VALUES];
+    uint8_t count;
+    bool known;
+} ConfigEntry;
+
+static ConfigEntry entries[CONFIG_COUNT];
+static ESP8266_AT_ConfigStats stats;
+
+// values of the last reply line of the query in flight
+static int32_t reply[ESP8266_AT_CONFIG_VALUES];
+static int8_t reply_count = -1;
+
+// verbs outside the table that only read or move data, never settings
+static const char *const read_only[] = {
+    "AT+CIPSTATUS", "AT+CIFSR", "AT+CWLAP", "AT+CWLIF", "AT+CIPSENDEX", "AT+CIPSENDBUF",
+    "AT+CIPBUFSTATUS", "AT+CIPCHECKSEQ", "AT+CIPRECVDATA", "AT+CIPRECVLEN", "AT+CIPSNTPTIME",
+};
+
+static ConfigIndex _Index(ESP8266_AT_CmdId id)
+{
+    switch (id)
+    {
+#define C(name)                \
+    case ESP8266_AT_CMD_##name: \
+        return CONFIG_##name;
+        ESP8266_AT_CONFIG(C)
+#undef C
+    default:
+        return CONFIG_NONE;
+    }
+}
+
+static void _Forget(ESP8266_AT_CmdId id)
+{
+    ConfigIndex index = _Index(id);
+    if (index != CONFIG_NONE)
+        entries[index].known = false;
+}
+
+void ESP8266_AT_Config_Invalidate(void)
+{
+    for (uint8_t i = 0; i < CONFIG_COUNT; i++)
+        entries[i].known = false;
+    reply_count = -1;
+    stats.invalidations++;
+}
+
+bool ESP8266_AT_Config_Tracked(ESP8266_AT_CmdId id)
+{
+    return _Index(id) != CONFIG_NONE;
+}
+
+bool ESP8266_AT_Config_Current(ESP8266_AT_CmdId id, uint8_t form,
+                               const ESP8266_AT_Arg *args, uint8_t count)
+{
+    ConfigIndex index = _Index(id);
+    if (index == CONFIG_NONE || !entries[index].known)
+        return false;
+
+    const ConfigEntry *entry = &entries[index];
+    if (form == ESP8266_AT_SET)
+    {
+        if (count != entry->count)
+            return false;
+        for (uint8_t i = 0; i < count; i++)
+            if ((int32_t)args[i].u != entry->values[i])
+                return false;
+    }
+    else if (form != ESP8266_AT_QUERY || ESP8266_AT_Commands[id].reply_len == 0)
+        return false;
+
+    stats.hits++;
+    return true;
+}
+
+int8_t ESP8266_AT_Config_Get(ESP8266_AT_CmdId id, int32_t *values, uint8_t max)
+{
+    ConfigIndex index = _Index(id);
+    if (index == CONFIG_NONE || !entries[index].known)
+        return -1;
+
+    const ConfigEntry *entry = &entries[index];
+    uint8_t n = entry->count < max ? entry->count : max;
+    memcpy(values, entry->values, n * sizeof(int32_t));
+
+    return entry->count;
+}
+
+uint16_t ESP8266_AT_Config_Reply(ESP8266_AT_CmdId id, char *buf, size_t size)
+{
+    ConfigIndex index = _Index(id);
+    if (index == CONFIG_NONE || !entries[index].known)
+        return 0;
+
+    const ESP8266_AT_Command *cmd = &ESP8266_AT_Commands[id];
+    const ConfigEntry *entry = &entries[index];
+    if (cmd->reply_len == 0 ||
+        size < cmd->reply_len + (size_t)entry->count * (ESP8266_AT_INT_CHARS + 1) + 1)
+        return 0;
+
+    memcpy(buf, cmd->reply, cmd->reply_len);
+    uint16_t len = cmd->reply_len;
+    for (uint8_t i = 0; i < entry->count; i++)
+    {
+        if (i > 0)
+            buf[len++] = ',';
+        len += ESP8266_AT_FormatInt(buf + len, entry->values[i]);
+    }
+    buf[len] = '\0';
+
+    return len;
+}
+
+void ESP8266_AT_Config_Sent(ESP8266_AT_CmdId id, uint8_t form)
+{
+    reply_count = -1;
+
+    switch (id)
+    {
+    // the module restarts and comes back with its saved settings
+    case ESP8266_AT_CMD_RESTORE:
+        // whatever the result, the _DEF settings may be gone
+        ESP8266_AT_Defaults_Forget();
+        ESP8266_AT_Config_Invalidate();
+        break;
+    case ESP8266_AT_CMD_RST:
+    case ESP8266_AT_CMD_GSLP:
+        ESP8266_AT_Config_Invalidate();
+        break;
+    // a verb not in the table, e.g. AT+CWMODE=1 or AT+UART=..., may
+    // change any setting; ESP8266_AT_Config_SentLine sorts out the reads
+    case ESP8266_AT_CMD_OTHER:
+        if (form != ESP8266_AT_QUERY)
+            ESP8266_AT_Config_Invalidate();
+        break;
+    // the _DEF forms apply to the running module as well
+    case ESP8266_AT_CMD_UART_DEF:
+        if (form != ESP8266_AT_QUERY)
+            _Forget(ESP8266_AT_CMD_UART_CUR);
+        break;
+    case ESP8266_AT_CMD_SYSMSG_DEF:
+        _Forget(ESP8266_AT_CMD_SYSMSG_CUR);
+        break;
+    case ESP8266_AT_CMD_CWMODE_DEF:
+        if (form != ESP8266_AT_QUERY)
+            _Forget(ESP8266_AT_CMD_CWMODE_CUR);
+        break;
+    default:
+        if (form != ESP8266_AT_QUERY)
+            _Forget(id);
+        break;
+    }
+}
+
+void ESP8266_AT_Config_SentLine(const char *line)
+{
+    size_t len = strcspn(line, "\r\n");
+    size_t verb_len = strcspn(line, "=?\r\n");
+    ESP8266_AT_CmdId id = ESP8266_AT_CommandId(line);
+
+    // AT+X? and AT+X=? only read
+    if (len > 0 && line[len - 1] == '?')
+    {
+        ESP8266_AT_Config_Sent(id, ESP8266_AT_QUERY);
+        return;
+    }
+
+    if (id == ESP8266_AT_CMD_OTHER)
+    {
+        for (uint8_t i = 0; i < sizeof(read_only) / sizeof(read_only[0]); i++)
+        {
+            if (strlen(read_only[i]) == verb_len && strncmp(line, read_only[i], verb_len) == 0)
+            {
+                ESP8266_AT_Config_Sent(id, ESP8266_AT_QUERY);
+                return;
+            }
+        }
+    }
+
+    ESP8266_AT_Config_Sent(id, line[verb_len] == '=' ? ESP8266_AT_SET : ESP8266_AT_EXEC);
+}
+
+void ESP8266_AT_Config_Line(ESP8266_AT_CmdId id, const char *line)
+{
+    if (_Index(id) == CONFIG_NONE)
+        return;
+
+    int8_t n = ESP8266_AT_ParseReply(id, line, reply, ESP8266_AT_CONFIG_VALUES);
+    if (n == ESP8266_AT_Commands[id].param_count)
+        reply_count = n;
+}
+
+void ESP8266_AT_Config_Done(ESP8266_AT_CmdId id, uint8_t form,
+                            const ESP8266_AT_Arg *args, uint8_t count, bool ok)
+{
+    ConfigIndex index = _Index(id);
+    if (index == CONFIG_NONE)
+        return;
+
+    ConfigEntry *entry = &entries[index];
+    if (ok && form == ESP8266_AT_SET && count == ESP8266_AT_Commands[id].param_count)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            entry->values[i] = (int32_t)args[i].u;
+        entry->count = count;
+        entry->known = true;
+    }
+    else if (ok && form == ESP8266_AT_QUERY && reply_count >= 0)
+    {
+        memcpy(entry->values, reply, reply_count * sizeof(int32_t));
+        entry->count = reply_count;
+        entry->known = true;
+    }
+    reply_count = -1;
+}
+
+void ESP8266_AT_Config_GetStats(ESP8266_AT_ConfigStats *out)
+{
+    *out = stats;
+}
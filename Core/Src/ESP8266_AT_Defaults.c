@@ -0,0 +1,211 @@
+#include "ESP8266_AT_Defaults.h"
+#include "ESP8266_AT_Flash.h"
+
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME 16777619U
+#define RECORDS (ESP8266_AT_DEFAULTS_SIZE / sizeof(Record))
+#define ERASED 0xFFFFFFFFU
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t check; // ~hash
+} Record;
+
+static const volatile Record *const records = (const volatile Record *)ESP8266_AT_DEFAULTS_ADDR;
+
+static uint32_t pending_hash;
+static uint8_t pending;
+static bool failed;
+static ESP8266_AT_DoneHandler done_handler;
+static void *done_ctx;
+
+static uint32_t _Mix(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+
+    return hash;
+}
+
+static uint32_t _MixString(uint32_t hash, const char *str)
+{
+    // the terminator keeps "ab","c" apart from "a","bc"
+    return str ? _Mix(hash, str, strlen(str) + 1) : _Mix(hash, "\xFF", 1);
+}
+
+static bool _Erased(uint32_t index)
+{
+    return records[index].hash == ERASED && records[index].check == ERASED;
+}
+
+// records are written in order, so the erased ones form the tail
+static uint32_t _FirstErased(void)
+{
+    uint32_t low = 0, high = RECORDS;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (_Erased(mid))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return low;
+}
+
+static void _Store(uint32_t hash)
+{
+    uint32_t index = _FirstErased();
+
+    HAL_FLASH_Unlock();
+    if (index == RECORDS)
+    {
+        // stalls the CPU for the erase; happens once every RECORDS writes
+        FLASH_EraseInitTypeDef erase = {
+            .TypeErase = FLASH_TYPEERASE_SECTORS,
+            .Sector = ESP8266_AT_DEFAULTS_SECTOR,
+            .NbSectors = 1,
+            .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+        };
+        uint32_t bad_sector;
+        if (HAL_FLASHEx_Erase(&erase, &bad_sector) != HAL_OK)
+        {
+            HAL_FLASH_Lock();
+            ESP8266_AT_Flash_FlushDataCache();
+            return;
+        }
+        index = 0;
+    }
+
+    uint32_t address = ESP8266_AT_DEFAULTS_ADDR + index * sizeof(Record);
+    // the check word goes last: a torn record never verifies
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, hash) == HAL_OK)
+        HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + sizeof(uint32_t), ~hash);
+    HAL_FLASH_Lock();
+    ESP8266_AT_Flash_FlushDataCache();
+}
+
+static void _Step(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    if (result != ESP8266_AT_OK)
+        failed = true;
+    if (--pending > 0)
+        return;
+
+    if (!failed)
+        _Store(pending_hash);
+    if (done_handler)
+        done_handler(failed ? ESP8266_AT_ERROR : ESP8266_AT_OK, done_ctx);
+}
+
+static void _Submit(ESP8266_AT_CmdId id, const ESP8266_AT_Arg *args, uint8_t count)
+{
+    if (ESP8266_AT_Async_SubmitCmd(id, ESP8266_AT_SET, args, count, 0, NULL, _Step, NULL))
+        pending++;
+    else
+        failed = true;
+}
+
+uint32_t ESP8266_AT_Defaults_Hash(const ESP8266_AT_Defaults *defaults)
+{
+    const uint8_t version = ESP8266_AT_DEFAULTS_VERSION;
+    const uint8_t fields[] = {defaults->wifi_mode, defaults->databits, defaults->stopbits,
+                              defaults->parity, defaults->flow_control, defaults->sysmsg,
+                              defaults->dhcp, defaults->auto_connect};
+
+    uint32_t hash = _Mix(FNV_OFFSET, &version, 1);
+    hash = _Mix(hash, fields, sizeof(fields));
+    hash = _Mix(hash, &defaults->baudrate, sizeof(defaults->baudrate));
+    if (!defaults->dhcp)
+    {
+        hash = _Mix(hash, defaults->ip, 4);
+        hash = _Mix(hash, defaults->gateway, 4);
+        hash = _Mix(hash, defaults->netmask, 4);
+    }
+    hash = _MixString(hash, defaults->ssid);
+    hash = _MixString(hash, defaults->password);
+
+    // 0 stands for no fingerprint
+    return hash ? hash : 1;
+}
+
+uint32_t ESP8266_AT_Defaults_Stored(void)
+{
+    uint32_t index = _FirstErased();
+    if (index == 0)
+        return 0;
+
+    uint32_t hash = records[index - 1].hash;
+    return records[index - 1].check == ~hash ? hash : 0;
+}
+
+ESP8266_AT_Result ESP8266_AT_Defaults_Apply(const ESP8266_AT_Defaults *defaults,
+                                            ESP8266_AT_DoneHandler on_done, void *ctx)
+{
+    // the earlier commands would complete into this count
+    if (pending != 0)
+        return ESP8266_AT_ERROR;
+
+    uint32_t hash = ESP8266_AT_Defaults_Hash(defaults);
+    if (hash == ESP8266_AT_Defaults_Stored())
+        return ESP8266_AT_OK;
+
+    pending_hash = hash;
+    pending = 0;
+    failed = false;
+    done_handler = on_done;
+    done_ctx = ctx;
+
+    ESP8266_AT_Arg args[5];
+
+    args[0].u = defaults->wifi_mode;
+    _Submit(ESP8266_AT_CMD_CWMODE_DEF, args, 1);
+
+    args[0].u = defaults->sysmsg;
+    _Submit(ESP8266_AT_CMD_SYSMSG_DEF, args, 1);
+
+    if (defaults->dhcp)
+    {
+        args[0].u = 1; // station
+        args[1].u = 1;
+        _Submit(ESP8266_AT_CMD_CWDHCP_DEF, args, 2);
+    }
+    else
+    {
+        // a static address turns station DHCP off by itself
+        args[0].bytes = defaults->ip;
+        args[1].bytes = defaults->gateway;
+        args[2].bytes = defaults->netmask;
+        _Submit(ESP8266_AT_CMD_CIPSTA_DEF, args, 3);
+    }
+
+    args[0].u = defaults->auto_connect;
+    _Submit(ESP8266_AT_CMD_CWAUTOCONN, args, 1);
+
+    if (defaults->ssid)
+    {
+        args[0].s = defaults->ssid;
+        args[1].s = defaults->password ? defaults->password : "";
+        _Submit(ESP8266_AT_CMD_CWJAP_DEF, args, 2);
+    }
+
+    // the module switches baud rate as soon as it answers
+    args[0].u = defaults->baudrate;
+    args[1].u = defaults->databits;
+    args[2].u = defaults->stopbits;
+    args[3].u = defaults->parity;
+    args[4].u = defaults->flow_control;
+    _Submit(ESP8266_AT_CMD_UART_DEF, args, 5);
+
+    return pending ? ESP8266_AT_PENDING : ESP8266_AT_ERROR;
+}
+
+void ESP8266_AT_Defaults_Forget(void)
+{
+    if (ESP8266_AT_Defaults_Stored() != 0)
+        _Store(0);
+}
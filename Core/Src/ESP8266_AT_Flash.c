@@ -0,0 +1,62 @@
+#include "ESP8266_AT_Flash.h"
+#include "stm32f4xx_hal.h"
+
+#define SECTOR_SIZE 0x20000U
+#define BANK0_ADDR 0x08020000U // sector 5
+#define BANK1_ADDR 0x08040000U // sector 6
+
+static const uint32_t sectors[2] = {FLASH_SECTOR_5, FLASH_SECTOR_6};
+static const uint32_t addresses[2] = {BANK0_ADDR, BANK1_ADDR};
+
+void ESP8266_AT_Flash_FlushDataCache(void)
+{
+    if (!(FLASH->ACR & FLASH_ACR_DCEN))
+        return;
+
+    __HAL_FLASH_DATA_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+}
+
+static bool _Erase(uint8_t bank)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Sector = sectors[bank],
+        .NbSectors = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+    };
+    uint32_t bad_sector;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &bad_sector);
+    HAL_FLASH_Lock();
+    ESP8266_AT_Flash_FlushDataCache();
+
+    return status == HAL_OK;
+}
+
+static bool _Program(uint8_t bank, uint32_t offset, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < len && status == HAL_OK; i += sizeof(uint32_t))
+    {
+        uint32_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addresses[bank] + offset + i, word);
+    }
+    HAL_FLASH_Lock();
+    ESP8266_AT_Flash_FlushDataCache();
+
+    return status == HAL_OK;
+}
+
+const ESP8266_AT_FlashOps ESP8266_AT_FlashStm32 = {
+    SECTOR_SIZE,
+    {(const uint8_t *)BANK0_ADDR, (const uint8_t *)BANK1_ADDR},
+    _Erase,
+    _Program,
+};
@@ -0,0 +1,210 @@
+#include "ESP8266_AT_Gpio.h"
+
+#define KIND_CFG 0
+#define KIND_DIR 1
+#define KIND_LEVEL 2
+#define KIND_READ 3
+
+#define CTX(kind, pin, value) ((void *)(uintptr_t)((kind) << 16 | (value) << 8 | (pin)))
+#define CTX_KIND(ctx) (((uintptr_t)(ctx) >> 16) & 0xFF)
+#define CTX_VALUE(ctx) (((uintptr_t)(ctx) >> 8) & 0xFF)
+#define CTX_PIN(ctx) ((uintptr_t)(ctx) & 0xFF)
+
+typedef struct
+{
+    uint16_t want;    // shadow requested by the application
+    uint16_t applied; // last value acknowledged by the module
+    uint16_t known;   // pins whose applied value is valid
+    uint16_t busy;    // pins with a command in flight
+    uint16_t declared; // pins the application has set at least once
+} Register;
+
+static Register dir;
+static Register level;
+static uint16_t cfg_dirty;
+static uint16_t cfg_declared; // pins the application has configured
+static uint16_t cfg_busy;
+static uint8_t cfg_mode[ESP8266_GPIO_PINS];
+static bool cfg_pull_up[ESP8266_GPIO_PINS];
+
+static uint16_t read_level;
+static uint16_t read_busy;
+static uint32_t read_at[ESP8266_GPIO_PINS];
+static uint16_t read_valid;
+static uint32_t staleness;
+
+static void _Done(ESP8266_AT_Result result, void *ctx)
+{
+    uint16_t bit = 1U << CTX_PIN(ctx);
+    Register *reg = CTX_KIND(ctx) == KIND_DIR ? &dir : &level;
+
+    switch (CTX_KIND(ctx))
+    {
+    case KIND_CFG:
+        cfg_busy &= ~bit;
+        if (result != ESP8266_AT_OK)
+            cfg_dirty |= bit;
+        break;
+
+    case KIND_DIR:
+    case KIND_LEVEL:
+        reg->busy &= ~bit;
+        if (result == ESP8266_AT_OK)
+        {
+            reg->applied = CTX_VALUE(ctx) ? reg->applied | bit : reg->applied & ~bit;
+            reg->known |= bit;
+        }
+        else
+            reg->known &= ~bit;
+        break;
+
+    case KIND_READ:
+        read_busy &= ~bit;
+        break;
+    }
+}
+
+static void _ReadLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    // +SYSGPIOREAD:<pin>,<dir>,<level>
+    int32_t fields[3];
+    if (ESP8266_AT_ParseReply(ESP8266_AT_CMD_SYSGPIOREAD, line, fields, 3) != 3 ||
+        fields[0] < 0 || fields[0] >= ESP8266_GPIO_PINS)
+        return;
+
+    uint8_t pin = fields[0];
+    uint16_t bit = 1U << pin;
+    if (fields[2])
+        read_level |= bit;
+    else
+        read_level &= ~bit;
+    read_valid |= bit;
+    read_at[pin] = HAL_GetTick();
+}
+
+static bool _Send(ESP8266_AT_CmdId id, uint8_t pin, uint8_t value, uint8_t kind)
+{
+    ESP8266_AT_Arg args[] = {{.u = pin}, {.u = value}};
+
+    return ESP8266_AT_Async_SubmitCmd(id, ESP8266_AT_SET, args, 2, 0, NULL, _Done, CTX(kind, pin, value));
+}
+
+static bool _Flush(Register *reg, ESP8266_AT_CmdId id, uint8_t kind)
+{
+    uint16_t dirty = ((reg->want ^ reg->applied) | ~reg->known) & ~reg->busy & reg->declared;
+
+    for (uint8_t pin = 0; dirty; pin++, dirty >>= 1)
+    {
+        if (!(dirty & 1))
+            continue;
+
+        bool value = reg->want & (1U << pin);
+        if (!_Send(id, pin, value, kind))
+            return false;
+        reg->busy |= 1U << pin;
+    }
+
+    return true;
+}
+
+void ESP8266_Gpio_Init(uint32_t staleness_ms)
+{
+    memset(&dir, 0, sizeof(dir));
+    memset(&level, 0, sizeof(level));
+    cfg_dirty = 0;
+    cfg_declared = 0;
+    cfg_busy = 0;
+    read_valid = 0;
+    read_busy = 0;
+    staleness = staleness_ms;
+}
+
+void ESP8266_Gpio_Configure(uint8_t pin, uint8_t mode, bool pull_up)
+{
+    if (pin >= ESP8266_GPIO_PINS)
+        return;
+
+    cfg_mode[pin] = mode;
+    cfg_pull_up[pin] = pull_up;
+    cfg_dirty |= 1U << pin;
+    cfg_declared |= 1U << pin;
+}
+
+void ESP8266_Gpio_SetDir(uint8_t pin, bool output)
+{
+    if (pin >= ESP8266_GPIO_PINS)
+        return;
+
+    dir.want = output ? dir.want | 1U << pin : dir.want & ~(1U << pin);
+    dir.declared |= 1U << pin;
+}
+
+void ESP8266_Gpio_Write(uint8_t pin, bool high)
+{
+    if (pin >= ESP8266_GPIO_PINS)
+        return;
+
+    level.want = high ? level.want | 1U << pin : level.want & ~(1U << pin);
+    level.declared |= 1U << pin;
+}
+
+bool ESP8266_Gpio_Read(uint8_t pin, bool *high)
+{
+    if (pin >= ESP8266_GPIO_PINS)
+        return false;
+
+    uint16_t bit = 1U << pin;
+    if ((read_valid & bit) && HAL_GetTick() - read_at[pin] <= staleness)
+    {
+        *high = read_level & bit;
+        return true;
+    }
+
+    if (!(read_busy & bit))
+    {
+        ESP8266_AT_Arg args[] = {{.u = pin}};
+        if (ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SYSGPIOREAD, ESP8266_AT_SET, args, 1, 0,
+                                       _ReadLine, _Done, CTX(KIND_READ, pin, 0)))
+            read_busy |= bit;
+    }
+
+    return false;
+}
+
+void ESP8266_Gpio_Process(void)
+{
+    // module order matters: IO mode, then direction, then level
+    uint16_t pending = cfg_dirty & ~cfg_busy;
+    for (uint8_t pin = 0; pending; pin++, pending >>= 1)
+    {
+        if (!(pending & 1))
+            continue;
+
+        ESP8266_AT_Arg args[] = {{.u = pin}, {.u = cfg_mode[pin]}, {.u = cfg_pull_up[pin]}};
+        if (!ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SYSIOSETCFG, ESP8266_AT_SET, args, 3, 0,
+                                        NULL, _Done, CTX(KIND_CFG, pin, 0)))
+            return;
+        cfg_dirty &= ~(1U << pin);
+        cfg_busy |= 1U << pin;
+    }
+
+    if (_Flush(&dir, ESP8266_AT_CMD_SYSGPIODIR, KIND_DIR))
+        _Flush(&level, ESP8266_AT_CMD_SYSGPIOWRITE, KIND_LEVEL);
+}
+
+void ESP8266_Gpio_Invalidate(void)
+{
+    cfg_dirty = cfg_declared;
+    dir.known = 0;
+    level.known = 0;
+    read_valid = 0;
+}
+
+bool ESP8266_Gpio_Synced(void)
+{
+    uint16_t dir_dirty = ((dir.want ^ dir.applied) | ~dir.known) & dir.declared;
+    uint16_t level_dirty = ((level.want ^ level.applied) | ~level.known) & level.declared;
+
+    return !cfg_dirty && !cfg_busy && !dir.busy && !level.busy && !dir_dirty && !level_dirty;
+}
@@ -0,0 +1,130 @@
+#include "ESP8266_AT_HeapWatch.h"
+
+static ESP8266_HeapWatchConfig watch;
+static ESP8266_HeapStats heap;
+static uint32_t sample;
+static uint32_t last_sample;
+static bool pending;
+static bool ssl_shrunk;
+static bool ssl_pending;
+
+static void _SslDone(ESP8266_AT_Result result, void *ctx)
+{
+    ssl_pending = false;
+    // on failure the buffer keeps its size and the next sample retries
+    if (result == ESP8266_AT_OK)
+        ssl_shrunk = (uintptr_t)ctx == ESP8266_HEAPWATCH_SSL_SMALL;
+}
+
+static void _SslSize(uint16_t size)
+{
+    ESP8266_AT_Arg args[] = {{.u = size}};
+
+    if (ssl_pending)
+        return;
+    if (ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_CIPSSLSIZE, ESP8266_AT_SET, args, 1, 0,
+                                   NULL, _SslDone, (void *)(uintptr_t)size))
+        ssl_pending = true;
+}
+
+static void _SysramLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    // +SYSRAM:<remaining RAM size>
+    int32_t value;
+    if (ESP8266_AT_ParseReply(ESP8266_AT_CMD_SYSRAM, line, &value, 1) == 1)
+        sample = value;
+}
+
+static void _SysramDone(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    pending = false;
+    if (result != ESP8266_AT_OK || sample == 0)
+        return;
+
+    heap.free_bytes = sample;
+    heap.samples++;
+    if (heap.low_water == 0 || sample < heap.low_water)
+        heap.low_water = sample;
+
+    ESP8266_HeapLevel level = ESP8266_HEAP_OK;
+    if (sample < watch.critical_bytes)
+        level = ESP8266_HEAP_CRITICAL;
+    else if (sample < watch.warn_bytes)
+        level = ESP8266_HEAP_WARN;
+
+    if (level != ESP8266_HEAP_OK && heap.level == ESP8266_HEAP_OK)
+        heap.warn_events++;
+    if (level == ESP8266_HEAP_CRITICAL && heap.level != ESP8266_HEAP_CRITICAL)
+        heap.critical_events++;
+    heap.level = level;
+
+    if (level == ESP8266_HEAP_CRITICAL && !ssl_shrunk)
+        _SslSize(ESP8266_HEAPWATCH_SSL_SMALL);
+    else if (level == ESP8266_HEAP_OK && ssl_shrunk)
+        _SslSize(ESP8266_HEAPWATCH_SSL_DEFAULT);
+}
+
+void ESP8266_HeapWatch_Init(const ESP8266_HeapWatchConfig *config)
+{
+    watch = *config;
+    memset(&heap, 0, sizeof(heap));
+    heap.level = ESP8266_HEAP_OK;
+    pending = false;
+    ssl_shrunk = false;
+    ssl_pending = false;
+    last_sample = HAL_GetTick() - watch.slow_period_ms;
+}
+
+void ESP8266_HeapWatch_Process(void)
+{
+    uint32_t period = heap.level == ESP8266_HEAP_OK ? watch.slow_period_ms : watch.fast_period_ms;
+
+    if (pending || HAL_GetTick() - last_sample < period)
+        return;
+
+    last_sample = HAL_GetTick();
+    sample = 0;
+    if (ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SYSRAM, ESP8266_AT_QUERY, NULL, 0, 0,
+                                   _SysramLine, _SysramDone, NULL))
+        pending = true;
+}
+
+bool ESP8266_HeapWatch_AllowNewLink(void)
+{
+    if (heap.level == ESP8266_HEAP_OK)
+        return true;
+
+    heap.links_refused++;
+    return false;
+}
+
+uint32_t ESP8266_HeapWatch_SendDelay(void)
+{
+    switch (heap.level)
+    {
+    case ESP8266_HEAP_WARN:
+        return watch.warn_delay_ms;
+    case ESP8266_HEAP_CRITICAL:
+        return watch.critical_delay_ms;
+    default:
+        return 0;
+    }
+}
+
+void ESP8266_HeapWatch_Invalidate(void)
+{
+    ssl_shrunk = false;
+    ssl_pending = false;
+}
+
+ESP8266_HeapLevel ESP8266_HeapWatch_Level(void)
+{
+    return heap.level;
+}
+
+void ESP8266_HeapWatch_GetStats(ESP8266_HeapStats *stats)
+{
+    *stats = heap;
+}
@@ -0,0 +1,203 @@
+#include "ESP8266_AT_Idle.h"
+
+// with PREDIV_A 1 the subseconds count LSI ticks in pairs, 62.5 us
+#define RTC_PREDIV_A 1
+#define RTC_PREDIV_S 15999
+#define LSI_START_MS 2
+#define RTC_SYNC_SPINS 100000 // polls of RSF, well over the two RTC clocks a sync takes
+#define DAY_US 86400000000ULL
+
+static GPIO_TypeDef *wake_port;
+static uint16_t wake_pin;
+static void (*clock_restore)(void);
+static bool rtc_running; // Stop is timed on the RTC, so no RTC, no Stop
+
+static uint32_t sleep_entries;
+static uint32_t stop_entries;
+static uint64_t asleep_us;
+static uint64_t stopped_us;
+static uint32_t tick_rest_us; // stopped time not yet added to the tick
+static uint32_t window_start; // HAL_GetTick, so windows may run for days
+
+// SysTick based microsecond clock, only meaningful while SysTick runs.
+// It wraps every 71.6 minutes: only good for differences shorter than that
+static uint32_t _Micros(void)
+{
+    uint32_t ms = HAL_GetTick();
+    uint32_t load = SysTick->LOAD;
+    uint32_t val = SysTick->VAL;
+
+    // wrapped but the tick interrupt has not run yet (interrupts masked)
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && val > load / 2)
+        ms++;
+
+    return ms * 1000 + (load - val) * 1000 / (load + 1);
+}
+
+static uint32_t _Bcd(uint32_t bcd)
+{
+    return (bcd >> 4) * 10 + (bcd & 0xF);
+}
+
+// starts the RTC on the LSI unless the application already runs it
+static bool _RtcStart(void)
+{
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    if (READ_BIT(RCC->BDCR, RCC_BDCR_RTCEN))
+        return true;
+
+    __HAL_RCC_LSI_ENABLE();
+    uint32_t start = HAL_GetTick();
+    while (!READ_BIT(RCC->CSR, RCC_CSR_LSIRDY))
+        if (HAL_GetTick() - start > LSI_START_MS)
+            return false;
+
+    if (__HAL_RCC_GET_RTC_SOURCE() == 0)
+        __HAL_RCC_RTC_CONFIG(RCC_RTCCLKSOURCE_LSI);
+    __HAL_RCC_RTC_ENABLE();
+
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    SET_BIT(RTC->ISR, RTC_ISR_INIT);
+    start = HAL_GetTick();
+    while (!READ_BIT(RTC->ISR, RTC_ISR_INITF) && HAL_GetTick() - start <= LSI_START_MS)
+        ;
+    // two separate writes, synchronous prescaler first
+    RTC->PRER = RTC_PREDIV_S;
+    RTC->PRER = RTC_PREDIV_S | RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+    CLEAR_BIT(RTC->ISR, RTC_ISR_INIT);
+    RTC->WPR = 0xFF;
+
+    return true;
+}
+
+// time of day on the RTC, which keeps counting in Stop mode; 24-hour format
+static uint64_t _RtcMicros(void)
+{
+    // reading SSR freezes the shadow registers until DR is read
+    uint32_t ssr = RTC->SSR;
+    uint32_t tr = RTC->TR;
+    (void)RTC->DR;
+
+    uint32_t prediv_s = RTC->PRER & RTC_PRER_PREDIV_S;
+    uint32_t seconds = _Bcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos) * 3600 +
+                       _Bcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos) * 60 +
+                       _Bcd((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+
+    return seconds * 1000000ULL + (uint64_t)(prediv_s - ssr) * 1000000 / (prediv_s + 1);
+}
+
+// the shadow registers hold the time from before Stop until the next
+// sync. Counted in polls, as the tick is still suspended
+static bool _RtcSync(void)
+{
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    CLEAR_BIT(RTC->ISR, RTC_ISR_RSF);
+    RTC->WPR = 0xFF;
+
+    for (uint32_t spins = 0; !READ_BIT(RTC->ISR, RTC_ISR_RSF); spins++)
+        if (spins == RTC_SYNC_SPINS)
+            return false;
+
+    return true;
+}
+
+static void _Stop(void)
+{
+    uint32_t line = POSITION_VAL(wake_pin);
+    uint32_t shift = 4 * (line & 3);
+
+    // wake event, not interrupt, on the falling start bit of RX
+    MODIFY_REG(SYSCFG->EXTICR[line >> 2], 0xFU << shift, GPIO_GET_INDEX(wake_port) << shift);
+    SET_BIT(EXTI->FTSR, wake_pin);
+    SET_BIT(EXTI->EMR, wake_pin);
+
+    uint64_t before = _RtcMicros();
+    HAL_SuspendTick();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFE);
+
+    if (clock_restore)
+        clock_restore();
+
+    // give the tick the time it missed, so timeouts and the stats see it.
+    // An RTC that no longer syncs cannot time Stop: it is not used again
+    if (_RtcSync())
+    {
+        uint32_t stopped = (_RtcMicros() + DAY_US - before) % DAY_US;
+        tick_rest_us += stopped;
+        uwTick += tick_rest_us / 1000;
+        tick_rest_us %= 1000;
+        stopped_us += stopped;
+    }
+    else
+        rtc_running = false;
+    HAL_ResumeTick();
+
+    CLEAR_BIT(EXTI->EMR, wake_pin);
+    CLEAR_BIT(EXTI->FTSR, wake_pin);
+    EXTI->PR = wake_pin;
+    stop_entries++;
+}
+
+void ESP8266_Idle_Init(GPIO_TypeDef *rx_port, uint16_t rx_pin, void (*restore_clock)(void))
+{
+    wake_port = rx_port;
+    wake_pin = rx_pin;
+    clock_restore = restore_clock;
+    rtc_running = rx_port != NULL && _RtcStart();
+
+    sleep_entries = 0;
+    stop_entries = 0;
+    asleep_us = 0;
+    stopped_us = 0;
+    tick_rest_us = 0;
+    window_start = HAL_GetTick();
+}
+
+void ESP8266_Idle_Enter(bool allow_stop)
+{
+    // masked so an interrupt landing after the check still wakes the WFI
+    __disable_irq();
+
+    if (ESP8266_AT_Async_WorkPending())
+    {
+        __enable_irq();
+        return;
+    }
+
+    if (allow_stop && wake_port != NULL && rtc_running && ESP8266_AT_Async_Quiet())
+    {
+        _Stop();
+        __enable_irq();
+        return;
+    }
+
+    uint32_t start = _Micros();
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    uint32_t end = _Micros();
+    __enable_irq();
+
+    asleep_us += end - start;
+    sleep_entries++;
+}
+
+void ESP8266_Idle_GetStats(ESP8266_IdleStats *stats)
+{
+    __disable_irq();
+    uint32_t now = HAL_GetTick();
+    uint64_t elapsed = (uint64_t)(now - window_start) * 1000;
+
+    stats->sleep_entries = sleep_entries;
+    stats->stop_entries = stop_entries;
+    stats->asleep_permille = elapsed ? (asleep_us + stopped_us) * 1000 / elapsed : 0;
+    stats->stopped_permille = elapsed ? stopped_us * 1000 / elapsed : 0;
+
+    sleep_entries = 0;
+    stop_entries = 0;
+    asleep_us = 0;
+    stopped_us = 0;
+    window_start = now;
+    __enable_irq();
+}
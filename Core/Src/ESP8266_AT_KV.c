@@ -0,0 +1,229 @@
+#include "ESP8266_AT_KV.h"
+
+#define MAGIC 0x3153564BU // "KVS1"
+#define ERASED 0xFFFFFFFFU
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME 16777619U
+
+/*
+ * Bank: {MAGIC, sequence} followed by records.
+ * Record: {key | len << 16}, value padded to a word with 0xFF, check
+ * word. len 0 marks a deleted key.
+ */
+#define BANK_HEADER 8
+#define RECORD_SIZE(len) (8 + (((uint32_t)(len) + 3) & ~3U))
+
+static const ESP8266_AT_FlashOps *flash;
+static uint8_t active;
+static uint32_t sequence;
+static uint32_t tail;    // where the next record goes
+static bool dirty;       // tail is not erased: compact before writing
+static uint32_t torn;
+static uint32_t offsets[ESP8266_AT_KV_KEYS]; // record offset, 0 when unset
+
+static uint32_t _Word(uint8_t bank, uint32_t offset)
+{
+    uint32_t word;
+    memcpy(&word, flash->base[bank] + offset, sizeof(word));
+
+    return word;
+}
+
+static uint32_t _Check(uint32_t header, const uint8_t *value, uint16_t len)
+{
+    uint32_t hash = FNV_OFFSET;
+    for (uint8_t i = 0; i < sizeof(header); i++)
+        hash = (hash ^ (uint8_t)(header >> (8 * i))) * FNV_PRIME;
+    for (uint16_t i = 0; i < len; i++)
+        hash = (hash ^ value[i]) * FNV_PRIME;
+
+    // an erased check word means the record was never committed
+    return hash == ERASED ? ERASED - 1 : hash;
+}
+
+static void _Scan(void)
+{
+    memset(offsets, 0, sizeof(offsets));
+    dirty = false;
+
+    uint32_t offset = BANK_HEADER;
+    while (offset + RECORD_SIZE(0) <= flash->size)
+    {
+        uint32_t header = _Word(active, offset);
+        if (header == ERASED)
+            break;
+
+        uint16_t key = header & 0xFFFF;
+        uint16_t len = header >> 16;
+        uint32_t size = RECORD_SIZE(len);
+        if (len > ESP8266_AT_KV_VALUE_MAX || offset + size > flash->size)
+        {
+            // a header torn mid-write: nothing after it can be trusted
+            dirty = true;
+            break;
+        }
+
+        const uint8_t *value = flash->base[active] + offset + 4;
+        if (_Check(header, value, len) != _Word(active, offset + size - 4))
+            torn++;
+        else if (key < ESP8266_AT_KV_KEYS)
+            offsets[key] = len ? offset : 0;
+
+        offset += size;
+    }
+    tail = offset;
+}
+
+static bool _Format(uint8_t bank, uint32_t seq)
+{
+    uint32_t header[2] = {MAGIC, seq};
+
+    return flash->erase(bank) && flash->program(bank, 0, header, sizeof(header));
+}
+
+// moves the live records to the other bank, which then becomes active
+static bool _Compact(void)
+{
+    uint8_t target = active ^ 1;
+    uint32_t moved[ESP8266_AT_KV_KEYS];
+    uint32_t offset = BANK_HEADER;
+
+    if (!flash->erase(target))
+        return false;
+
+    for (uint16_t key = 0; key < ESP8266_AT_KV_KEYS; key++)
+    {
+        moved[key] = 0;
+        if (offsets[key] == 0)
+            continue;
+
+        // copied whole, check word included, so it stays valid
+        uint32_t size = RECORD_SIZE(_Word(active, offsets[key]) >> 16);
+        if (!flash->program(target, offset, flash->base[active] + offsets[key], size))
+            return false;
+        moved[key] = offset;
+        offset += size;
+    }
+
+    // the header goes last: until it is written the old bank is current
+    uint32_t header[2] = {MAGIC, sequence + 1};
+    if (!flash->program(target, 0, header, sizeof(header)))
+        return false;
+
+    active = target;
+    sequence++;
+    tail = offset;
+    dirty = false;
+    memcpy(offsets, moved, sizeof(offsets));
+
+    return true;
+}
+
+static bool _Append(uint16_t key, const void *data, uint16_t len)
+{
+    uint32_t size = RECORD_SIZE(len);
+
+    if ((dirty || tail + size > flash->size) && !_Compact())
+        return false;
+    if (tail + size > flash->size)
+        return false;
+
+    uint32_t record[RECORD_SIZE(ESP8266_AT_KV_VALUE_MAX) / sizeof(uint32_t)];
+    uint8_t *bytes = (uint8_t *)record;
+
+    record[0] = key | (uint32_t)len << 16;
+    memset(bytes + 4, 0xFF, size - 8);
+    if (len)
+        memcpy(bytes + 4, data, len);
+
+    // the check word commits the record, so it is programmed on its own
+    uint32_t check = _Check(record[0], bytes + 4, len);
+    if (!flash->program(active, tail, record, size - 4) ||
+        !flash->program(active, tail + size - 4, &check, sizeof(check)))
+    {
+        dirty = true;
+        return false;
+    }
+
+    offsets[key] = len ? tail : 0;
+    tail += size;
+
+    return true;
+}
+
+bool ESP8266_AT_KV_Init(const ESP8266_AT_FlashOps *ops)
+{
+    flash = ops;
+    torn = 0;
+
+    bool valid[2];
+    uint32_t seq[2];
+    for (uint8_t bank = 0; bank < 2; bank++)
+    {
+        valid[bank] = _Word(bank, 0) == MAGIC;
+        seq[bank] = _Word(bank, 4);
+    }
+
+    if (!valid[0] && !valid[1])
+    {
+        active = 0;
+        sequence = 1;
+        if (!_Format(active, sequence))
+            return false;
+    }
+    else
+    {
+        active = !valid[0] || (valid[1] && (int32_t)(seq[1] - seq[0]) > 0);
+        sequence = seq[active];
+    }
+
+    _Scan();
+    return true;
+}
+
+int16_t ESP8266_AT_KV_Get(uint16_t key, void *buf, uint16_t size)
+{
+    if (flash == NULL || key >= ESP8266_AT_KV_KEYS || offsets[key] == 0)
+        return -1;
+
+    uint16_t len = _Word(active, offsets[key]) >> 16;
+    memcpy(buf, flash->base[active] + offsets[key] + 4, len < size ? len : size);
+
+    return len;
+}
+
+bool ESP8266_AT_KV_Set(uint16_t key, const void *data, uint16_t len)
+{
+    if (flash == NULL || key >= ESP8266_AT_KV_KEYS || len == 0 || len > ESP8266_AT_KV_VALUE_MAX)
+        return false;
+
+    // rewriting an unchanged value would only wear the flash
+    if (offsets[key] != 0 && _Word(active, offsets[key]) >> 16 == len &&
+        memcmp(flash->base[active] + offsets[key] + 4, data, len) == 0)
+        return true;
+
+    return _Append(key, data, len);
+}
+
+bool ESP8266_AT_KV_Delete(uint16_t key)
+{
+    if (flash == NULL || key >= ESP8266_AT_KV_KEYS)
+        return false;
+    if (offsets[key] == 0)
+        return true;
+
+    return _Append(key, NULL, 0);
+}
+
+void ESP8266_AT_KV_GetStats(ESP8266_AT_KVStats *stats)
+{
+    stats->used = tail;
+    stats->live = BANK_HEADER;
+    for (uint16_t key = 0; key < ESP8266_AT_KV_KEYS; key++)
+        if (offsets[key] != 0)
+            stats->live += RECORD_SIZE(_Word(active, offsets[key]) >> 16);
+    stats->size = flash ? flash->size : 0;
+    stats->sequence = sequence;
+    stats->torn = torn;
+    stats->bank = active;
+}
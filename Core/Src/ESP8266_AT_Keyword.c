@@ -0,0 +1,95 @@
+#include "ESP8266_AT_Keyword.h"
+
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME 16777619U
+
+typedef struct
+{
+    const char *text;
+    uint8_t len;
+} Keyword;
+
+static const Keyword keywords[ESP8266_AT_KW_NONE] = {
+#define K(name, text) {text, sizeof(text) - 1},
+    ESP8266_AT_KEYWORDS(K)
+#undef K
+};
+
+// keyword id + 1 per slot, 0 when empty
+static uint8_t slots[1U << ESP8266_AT_KEYWORD_SLOT_BITS];
+
+ESP8266_AT_RAMFUNC static inline bool _Delimiter(char c)
+{
+    return c == ':' || c == ',' || c == ' ';
+}
+
+ESP8266_AT_RAMFUNC static inline uint32_t _Slot(uint32_t hash)
+{
+    // multiplicative hashing: the top bits of the product are the best mixed
+    return (hash * ESP8266_AT_KEYWORD_SEED) >> (32 - ESP8266_AT_KEYWORD_SLOT_BITS);
+}
+
+// "<link id>,CONNECT": the keyword follows the id
+ESP8266_AT_RAMFUNC static inline uint16_t _Start(const char *line, uint16_t len)
+{
+    return len > 2 && line[0] >= '0' && line[0] <= '9' && line[1] == ',' ? 2 : 0;
+}
+
+bool ESP8266_AT_Keyword_Init(void)
+{
+    memset(slots, 0, sizeof(slots));
+
+    for (uint8_t id = 0; id < ESP8266_AT_KW_NONE; id++)
+    {
+        uint32_t hash = FNV_OFFSET;
+        for (uint8_t i = 0; i < keywords[id].len; i++)
+            hash = (hash ^ (uint8_t)keywords[id].text[i]) * FNV_PRIME;
+
+        uint32_t slot = _Slot(hash);
+        if (slots[slot])
+            return false;
+        slots[slot] = id + 1;
+    }
+
+    return true;
+}
+
+ESP8266_AT_RAMFUNC ESP8266_AT_KeywordId ESP8266_AT_Keyword_Match(const char *line, uint16_t len)
+{
+    uint16_t start = _Start(line, len);
+    const char *text = line + start;
+    uint16_t n = len - start;
+    uint32_t hash = FNV_OFFSET;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        hash = (hash ^ (uint8_t)text[i]) * FNV_PRIME;
+
+        // a keyword ends here if it is a prefix, or if the line does
+        if (!_Delimiter(text[i]) && i + 1 < n)
+            continue;
+
+        uint8_t entry = slots[_Slot(hash)];
+        if (entry && keywords[entry - 1].len == i + 1 && memcmp(text, keywords[entry - 1].text, i + 1) == 0)
+            return (ESP8266_AT_KeywordId)(entry - 1);
+    }
+
+    return ESP8266_AT_KW_NONE;
+}
+
+ESP8266_AT_KeywordId ESP8266_AT_Keyword_MatchLinear(const char *line, uint16_t len)
+{
+    uint16_t start = _Start(line, len);
+    const char *text = line + start;
+    uint16_t n = len - start;
+
+    for (uint8_t id = 0; id < ESP8266_AT_KW_NONE; id++)
+    {
+        bool prefix = _Delimiter(keywords[id].text[keywords[id].len - 1]);
+        if ((prefix ? n >= keywords[id].len : n == keywords[id].len) &&
+            strncmp(text, keywords[id].text, keywords[id].len) == 0)
+            return (ESP8266_AT_KeywordId)id;
+    }
+
+    return ESP8266_AT_KW_NONE;
+}
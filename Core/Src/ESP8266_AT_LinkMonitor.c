@@ -0,0 +1,177 @@
+#include "ESP8266_AT_LinkMonitor.h"
+
+#define LOST 0xFFFF
+
+static const char *ping_host;
+static uint32_t ping_period;
+static uint32_t last_ping;
+static bool started;
+static bool ping_pending;
+static bool rssi_pending;
+static bool rssi_seen; // +CWJAP_CUR: received for the query in flight
+
+static uint16_t window[ESP8266_LINKMON_WINDOW];
+static uint8_t window_next;
+static uint8_t window_count;
+static uint16_t ping_rtt;
+static uint32_t lost;
+static int8_t rssi;
+
+static void _Record(uint16_t rtt)
+{
+    if (rtt == LOST)
+        lost++;
+    window[window_next] = rtt;
+    window_next = (window_next + 1) % ESP8266_LINKMON_WINDOW;
+    if (window_count < ESP8266_LINKMON_WINDOW)
+        window_count++;
+}
+
+static void _PingLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    // +<time> on success, +timeout on failure
+    int32_t rtt;
+    if (ESP8266_AT_ParseReply(ESP8266_AT_CMD_PING, line, &rtt, 1) == 1 && rtt >= 0)
+        ping_rtt = rtt < LOST ? rtt : LOST - 1;
+}
+
+static void _PingDone(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    _Record(result == ESP8266_AT_OK && ping_rtt != LOST ? ping_rtt : LOST);
+    ping_pending = false;
+}
+
+static void _RssiLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    // +CWJAP_CUR:<ssid>,<bssid>,<channel>,<rssi>
+    int32_t fields[4];
+    if (ESP8266_AT_ParseReply(ESP8266_AT_CMD_CWJAP_CUR, line, fields, 4) == 4)
+    {
+        rssi = (int8_t)fields[3];
+        rssi_seen = true;
+    }
+}
+
+static void _RssiDone(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    // not connected: No AP, OK, so OK alone does not mean an RSSI came
+    if (result != ESP8266_AT_OK || !rssi_seen)
+        rssi = 0;
+    rssi_pending = false;
+}
+
+void ESP8266_LinkMonitor_Init(const char *host, uint32_t period_ms)
+{
+    ping_host = host;
+    ping_period = period_ms;
+    started = false;
+    window_next = 0;
+    window_count = 0;
+    lost = 0;
+    rssi = 0;
+}
+
+void ESP8266_LinkMonitor_Process(void)
+{
+    if (ping_host == NULL || ping_pending || rssi_pending)
+        return;
+
+    uint32_t now = HAL_GetTick();
+    if (started && now - last_ping < ping_period)
+        return;
+
+    ESP8266_AT_Arg args[] = {{.s = ping_host}};
+
+    ping_rtt = LOST;
+    // keepalives go out ahead of queued bulk traffic
+    if (!ESP8266_AT_Async_SubmitPrio(ESP8266_AT_PRIO_HIGH, ESP8266_AT_CMD_PING, ESP8266_AT_SET,
+                                     args, 1, ESP8266_LINKMON_PING_TIMEOUT, _PingLine, _PingDone,
+                                     NULL))
+        return;
+    ping_pending = true;
+
+    rssi_seen = false;
+    if (ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_CWJAP_CUR, ESP8266_AT_QUERY, NULL, 0, 1000,
+                                   _RssiLine, _RssiDone, NULL))
+        rssi_pending = true;
+
+    started = true;
+    last_ping = now;
+}
+
+void ESP8266_LinkMonitor_GetStats(ESP8266_LinkStats *stats)
+{
+    uint32_t sum = 0, jitter_sum = 0;
+    uint16_t min = LOST, max = 0, prev = LOST;
+    uint8_t received = 0, pairs = 0;
+
+    // walk oldest to newest so jitter follows arrival order
+    uint8_t first = (window_next + ESP8266_LINKMON_WINDOW - window_count) % ESP8266_LINKMON_WINDOW;
+    for (uint8_t i = 0; i < window_count; i++)
+    {
+        uint16_t rtt = window[(first + i) % ESP8266_LINKMON_WINDOW];
+        if (rtt == LOST)
+            continue;
+
+        if (rtt < min)
+            min = rtt;
+        if (rtt > max)
+            max = rtt;
+        sum += rtt;
+        received++;
+
+        if (prev != LOST)
+        {
+            jitter_sum += rtt > prev ? rtt - prev : prev - rtt;
+            pairs++;
+        }
+        prev = rtt;
+    }
+
+    stats->samples = window_count;
+    stats->lost = lost;
+    stats->rssi = rssi;
+    stats->min_ms = received ? min : 0;
+    stats->max_ms = max;
+    stats->avg_ms = received ? sum / received : 0;
+    stats->jitter_ms = pairs ? jitter_sum / pairs : 0;
+    stats->loss_pct = window_count ? (window_count - received) * 100 / window_count : 0;
+
+    if (received == 0)
+    {
+        stats->score = 0;
+        return;
+    }
+
+    // 20 ms or better scores full marks, 520 ms or worse scores nothing;
+    // jitter counts double as it hurts streaming more than steady delay
+    int32_t delay = stats->avg_ms + 2 * stats->jitter_ms - 20;
+    int32_t latency_score = 100 - (delay < 0 ? 0 : delay / 5);
+    if (latency_score < 0)
+        latency_score = 0;
+
+    // -90 dBm or worse scores nothing, -50 dBm or better full marks
+    int32_t rssi_score = 100;
+    if (rssi != 0)
+    {
+        rssi_score = (rssi + 90) * 100 / 40;
+        if (rssi_score < 0)
+            rssi_score = 0;
+        if (rssi_score > 100)
+            rssi_score = 100;
+    }
+
+    stats->score = latency_score * rssi_score / 100 * (100 - stats->loss_pct) / 100;
+}
+
+uint8_t ESP8266_LinkMonitor_Score(void)
+{
+    ESP8266_LinkStats stats;
+    ESP8266_LinkMonitor_GetStats(&stats);
+
+    return stats.score;
+}
@@ -0,0 +1,139 @@
+#include "ESP8266_AT_Metrics.h"
+
+static ESP8266_Metrics metrics;
+static uint32_t window_start;
+static volatile uint32_t isr_bytes_rx;
+static volatile uint32_t isr_overruns;
+
+static uint8_t *_Varint(uint8_t *out, const uint8_t *end, uint32_t value)
+{
+    do
+    {
+        if (out == NULL || out == end)
+            return NULL;
+
+        *out++ = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+        value >>= 7;
+    } while (value);
+
+    return out;
+}
+
+void ESP8266_Metrics_Snapshot(ESP8266_Metrics *out)
+{
+    uint32_t now = HAL_GetTick();
+
+    *out = metrics;
+    memset(&metrics, 0, sizeof(metrics));
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    out->bytes_rx = isr_bytes_rx;
+    out->rx_overruns = isr_overruns;
+    isr_bytes_rx = 0;
+    isr_overruns = 0;
+    __set_PRIMASK(primask);
+
+    out->window_ms = now - window_start;
+    window_start = now;
+}
+
+size_t ESP8266_Metrics_Serialize(const ESP8266_Metrics *m, uint8_t *buf, size_t len)
+{
+    const uint8_t *end = buf + len;
+    uint8_t *out = buf;
+    uint8_t count = 0;
+
+    if (len < 2)
+        return 0;
+    *out++ = 'M';
+    *out++ = ESP8266_METRICS_VERSION;
+
+    out = _Varint(out, end, m->window_ms);
+    out = _Varint(out, end, m->bytes_tx);
+    out = _Varint(out, end, m->bytes_rx);
+    out = _Varint(out, end, m->resyncs);
+    out = _Varint(out, end, m->busy);
+    out = _Varint(out, end, m->rx_overruns);
+
+    for (uint8_t id = 0; id < ESP8266_AT_CMD_COUNT; id++)
+        count += m->cmd[id].sent > 0;
+
+    if (out == NULL || out == end)
+        return 0;
+    *out++ = count;
+
+    for (uint8_t id = 0; id < ESP8266_AT_CMD_COUNT; id++)
+    {
+        const ESP8266_CmdMetrics *cmd = &m->cmd[id];
+        if (cmd->sent == 0)
+            continue;
+
+        if (out == NULL || out == end)
+            return 0;
+        *out++ = id;
+        out = _Varint(out, end, cmd->sent);
+        out = _Varint(out, end, cmd->ok);
+        out = _Varint(out, end, cmd->error);
+        out = _Varint(out, end, cmd->timeout);
+        for (uint8_t i = 0; i < ESP8266_METRICS_RTT_BUCKETS; i++)
+            out = _Varint(out, end, cmd->rtt_hist[i]);
+    }
+
+    return out ? out - buf : 0;
+}
+
+void ESP8266_Metrics_Sent(ESP8266_AT_CmdId id, uint16_t bytes)
+{
+    metrics.cmd[id].sent++;
+    metrics.bytes_tx += bytes;
+}
+
+void ESP8266_Metrics_Payload(uint16_t bytes)
+{
+    metrics.bytes_tx += bytes;
+}
+
+void ESP8266_Metrics_Done(ESP8266_AT_CmdId id, ESP8266_AT_Result result, uint32_t rtt_ms)
+{
+    ESP8266_CmdMetrics *cmd = &metrics.cmd[id];
+
+    switch (result)
+    {
+    case ESP8266_AT_OK:
+        cmd->ok++;
+        break;
+    case ESP8266_AT_TIMEOUT:
+        cmd->timeout++;
+        break;
+    default:
+        cmd->error++;
+        break;
+    }
+
+    uint32_t bucket = rtt_ms ? 32 - __builtin_clz(rtt_ms) : 0;
+    if (bucket >= ESP8266_METRICS_RTT_BUCKETS)
+        bucket = ESP8266_METRICS_RTT_BUCKETS - 1;
+    if (cmd->rtt_hist[bucket] != UINT16_MAX)
+        cmd->rtt_hist[bucket]++;
+}
+
+void ESP8266_Metrics_Resync(void)
+{
+    metrics.resyncs++;
+}
+
+void ESP8266_Metrics_Busy(void)
+{
+    metrics.busy++;
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_Metrics_Received(void)
+{
+    isr_bytes_rx++;
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_Metrics_Overrun(void)
+{
+    isr_overruns++;
+}
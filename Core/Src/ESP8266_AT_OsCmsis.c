@@ -0,0 +1,72 @@
+#include "ESP8266_AT_Os.h"
+
+#ifdef ESP8266_AT_OS_CMSIS_RTOS2
+
+static uint32_t _Ticks(uint32_t ms)
+{
+    if (ms == ESP8266_AT_OS_FOREVER)
+        return osWaitForever;
+
+    // round up so a short wait never becomes a poll
+    return (uint32_t)(((uint64_t)ms * osKernelGetTickFreq() + 999) / 1000);
+}
+
+bool ESP8266_AT_Os_MutexInit(ESP8266_AT_OsMutex *mutex)
+{
+    const osMutexAttr_t attr = {.name = "esp8266", .attr_bits = osMutexPrioInherit};
+
+    *mutex = osMutexNew(&attr);
+    return *mutex != NULL;
+}
+
+void ESP8266_AT_Os_MutexLock(ESP8266_AT_OsMutex *mutex)
+{
+    osMutexAcquire(*mutex, osWaitForever);
+}
+
+void ESP8266_AT_Os_MutexUnlock(ESP8266_AT_OsMutex *mutex)
+{
+    osMutexRelease(*mutex);
+}
+
+bool ESP8266_AT_Os_FlagsInit(ESP8266_AT_OsFlags *flags)
+{
+    *flags = osEventFlagsNew(NULL);
+    return *flags != NULL;
+}
+
+void ESP8266_AT_Os_FlagsSet(ESP8266_AT_OsFlags *flags, uint32_t bits)
+{
+    osEventFlagsSet(*flags, bits);
+}
+
+uint32_t ESP8266_AT_Os_FlagsWait(ESP8266_AT_OsFlags *flags, uint32_t bits, uint32_t timeout)
+{
+    uint32_t set = osEventFlagsWait(*flags, bits, osFlagsWaitAny, _Ticks(timeout));
+
+    // errors, timeout included, come back with the top bit set
+    return (set & osFlagsError) ? 0 : set & bits;
+}
+
+bool ESP8266_AT_Os_QueueInit(ESP8266_AT_OsQueue *queue, uint16_t item_size, uint16_t length)
+{
+    *queue = osMessageQueueNew(length, item_size, NULL);
+    return *queue != NULL;
+}
+
+bool ESP8266_AT_Os_QueuePut(ESP8266_AT_OsQueue *queue, const void *item, uint32_t timeout)
+{
+    return osMessageQueuePut(*queue, item, 0, _Ticks(timeout)) == osOK;
+}
+
+bool ESP8266_AT_Os_QueueGet(ESP8266_AT_OsQueue *queue, void *item, uint32_t timeout)
+{
+    return osMessageQueueGet(*queue, item, NULL, _Ticks(timeout)) == osOK;
+}
+
+uint32_t ESP8266_AT_Os_Tick(void)
+{
+    return (uint32_t)((uint64_t)osKernelGetTickCount() * 1000 / osKernelGetTickFreq());
+}
+
+#endif
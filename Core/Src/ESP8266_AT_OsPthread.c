@@ -0,0 +1,161 @@
+#include "ESP8266_AT_Os.h"
+
+#ifdef ESP8266_AT_OS_PTHREAD
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static bool _CondInit(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    bool ok = pthread_condattr_init(&attr) == 0;
+
+    // deadlines on the monotonic clock do not jump with the wall clock
+    ok = ok && pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0;
+    ok = ok && pthread_cond_init(cond, &attr) == 0;
+    pthread_condattr_destroy(&attr);
+
+    return ok;
+}
+
+static struct timespec _Deadline(uint32_t ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    return ts;
+}
+
+// waits on <cond> once; false when <deadline> has passed
+static bool _Wait(pthread_cond_t *cond, pthread_mutex_t *lock, uint32_t timeout,
+                  const struct timespec *deadline)
+{
+    if (timeout == ESP8266_AT_OS_FOREVER)
+        return pthread_cond_wait(cond, lock) == 0;
+
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+bool ESP8266_AT_Os_MutexInit(ESP8266_AT_OsMutex *mutex)
+{
+    pthread_mutexattr_t attr;
+    bool ok = pthread_mutexattr_init(&attr) == 0;
+
+    // lock errors abort Test_Sync instead of hanging it
+    ok = ok && pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK) == 0;
+    ok = ok && pthread_mutex_init(mutex, &attr) == 0;
+    pthread_mutexattr_destroy(&attr);
+
+    return ok;
+}
+
+void ESP8266_AT_Os_MutexLock(ESP8266_AT_OsMutex *mutex)
+{
+    if (pthread_mutex_lock(mutex) != 0)
+        abort();
+}
+
+void ESP8266_AT_Os_MutexUnlock(ESP8266_AT_OsMutex *mutex)
+{
+    if (pthread_mutex_unlock(mutex) != 0)
+        abort();
+}
+
+bool ESP8266_AT_Os_FlagsInit(ESP8266_AT_OsFlags *flags)
+{
+    flags->bits = 0;
+
+    return pthread_mutex_init(&flags->lock, NULL) == 0 && _CondInit(&flags->changed);
+}
+
+void ESP8266_AT_Os_FlagsSet(ESP8266_AT_OsFlags *flags, uint32_t bits)
+{
+    pthread_mutex_lock(&flags->lock);
+    flags->bits |= bits;
+    pthread_cond_broadcast(&flags->changed);
+    pthread_mutex_unlock(&flags->lock);
+}
+
+uint32_t ESP8266_AT_Os_FlagsWait(ESP8266_AT_OsFlags *flags, uint32_t bits, uint32_t timeout)
+{
+    struct timespec deadline = _Deadline(timeout == ESP8266_AT_OS_FOREVER ? 0 : timeout);
+
+    pthread_mutex_lock(&flags->lock);
+    while (!(flags->bits & bits) && _Wait(&flags->changed, &flags->lock, timeout, &deadline))
+        ;
+    uint32_t set = flags->bits & bits;
+    flags->bits &= ~set;
+    pthread_mutex_unlock(&flags->lock);
+
+    return set;
+}
+
+bool ESP8266_AT_Os_QueueInit(ESP8266_AT_OsQueue *queue, uint16_t item_size, uint16_t length)
+{
+    queue->items = malloc((size_t)item_size * length);
+    queue->item_size = item_size;
+    queue->length = length;
+    queue->head = 0;
+    queue->count = 0;
+
+    return queue->items && pthread_mutex_init(&queue->lock, NULL) == 0 && _CondInit(&queue->changed);
+}
+
+bool ESP8266_AT_Os_QueuePut(ESP8266_AT_OsQueue *queue, const void *item, uint32_t timeout)
+{
+    struct timespec deadline = _Deadline(timeout == ESP8266_AT_OS_FOREVER ? 0 : timeout);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && _Wait(&queue->changed, &queue->lock, timeout, &deadline))
+        ;
+    bool room = queue->count < queue->length;
+    if (room)
+    {
+        uint16_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return room;
+}
+
+bool ESP8266_AT_Os_QueueGet(ESP8266_AT_OsQueue *queue, void *item, uint32_t timeout)
+{
+    struct timespec deadline = _Deadline(timeout == ESP8266_AT_OS_FOREVER ? 0 : timeout);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && _Wait(&queue->changed, &queue->lock, timeout, &deadline))
+        ;
+    bool got = queue->count > 0;
+    if (got)
+    {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return got;
+}
+
+uint32_t ESP8266_AT_Os_Tick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "ESP8266_AT_Pool.h"
+
+void ESP8266_AT_Pool_Init(ESP8266_AT_Pool *pool)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    pool->free = NULL;
+    // link from the end so blocks are handed out in address order
+    for (uint16_t i = pool->count; i > 0; i--)
+    {
+        void **block = (void **)(pool->storage + (size_t)(i - 1) * pool->block_size);
+        *block = pool->free;
+        pool->free = block;
+    }
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->failures = 0;
+
+    __set_PRIMASK(primask);
+}
+
+void *ESP8266_AT_Pool_Alloc(ESP8266_AT_Pool *pool)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    void **block = pool->free;
+    if (block)
+    {
+        pool->free = *block;
+        if (++pool->used > pool->high_water)
+            pool->high_water = pool->used;
+    }
+    else
+        pool->failures++;
+
+    __set_PRIMASK(primask);
+    return block;
+}
+
+void ESP8266_AT_Pool_Free(ESP8266_AT_Pool *pool, void *block)
+{
+    uint8_t *at = block;
+    if (at < pool->storage || at >= pool->storage + (size_t)pool->count * pool->block_size ||
+        (size_t)(at - pool->storage) % pool->block_size != 0)
+        return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *(void **)block = pool->free;
+    pool->free = block;
+    pool->used--;
+
+    __set_PRIMASK(primask);
+}
+
+void ESP8266_AT_Pool_GetStats(const ESP8266_AT_Pool *pool, ESP8266_AT_PoolStats *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    stats->count = pool->count;
+    stats->used = pool->used;
+    stats->high_water = pool->high_water;
+    stats->failures = pool->failures;
+
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,216 @@
+#include "ESP8266_AT_Power.h"
+
+typedef enum
+{
+    STATE_AWAKE,
+    STATE_ENTERING,
+    STATE_ASLEEP,
+    STATE_SETTLING
+} PowerState;
+
+static ESP8266_PowerConfig power;
+static PowerState state;
+static ESP8266_PowerMode sleeping_in;
+static uint32_t wake_at;
+static uint32_t settle_start;
+static uint32_t sleep_ms;
+static int8_t module_sleep_mode; // AT+SLEEP value, -1 when unknown
+static bool wakeup_gpio_set;
+
+static void _WakePin(bool asserted)
+{
+    if (power.wake_port == NULL)
+        return;
+
+    bool level = asserted ? power.trigger_level : !power.trigger_level;
+    HAL_GPIO_WritePin(power.wake_port, power.wake_pin, level ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+static void _Awake(void)
+{
+    state = STATE_AWAKE;
+    ESP8266_AT_Async_Hold(false);
+
+    if (power.on_wake)
+        power.on_wake(sleeping_in);
+}
+
+static void _SleepModeSet(ESP8266_AT_Result result, void *ctx)
+{
+    module_sleep_mode = result == ESP8266_AT_OK ? (int8_t)(intptr_t)ctx : -1;
+}
+
+static void _WakeupGpioSet(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    wakeup_gpio_set = result == ESP8266_AT_OK;
+}
+
+static void _Entered(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    if (result != ESP8266_AT_OK)
+    {
+        if (sleeping_in == ESP8266_POWER_LIGHT_SLEEP)
+            module_sleep_mode = -1;
+        state = STATE_AWAKE;
+        return;
+    }
+
+    if (sleeping_in == ESP8266_POWER_LIGHT_SLEEP)
+    {
+        module_sleep_mode = 1;
+        // the module only enters Light-sleep while the trigger is inactive
+        _WakePin(false);
+    }
+
+    ESP8266_AT_Async_Hold(true);
+    wake_at = HAL_GetTick() + sleep_ms;
+    state = STATE_ASLEEP;
+}
+
+static uint32_t _Energy(uint32_t sleep_ua, uint32_t interval_ms, uint32_t wake_ms)
+{
+    uint32_t asleep = interval_ms > wake_ms ? interval_ms - wake_ms : 0;
+    uint64_t charge = (uint64_t)sleep_ua * asleep + (uint64_t)ESP8266_POWER_ACTIVE_UA * wake_ms;
+
+    return charge * ESP8266_POWER_VDD_MV / 1000000;
+}
+
+void ESP8266_Power_Init(const ESP8266_PowerConfig *config)
+{
+    power = *config;
+    state = STATE_AWAKE;
+    sleeping_in = ESP8266_POWER_ACTIVE;
+    module_sleep_mode = -1;
+    wakeup_gpio_set = false;
+
+    // keeping the trigger asserted holds the module in Modem-sleep
+    _WakePin(true);
+}
+
+uint32_t ESP8266_Power_Energy(ESP8266_PowerMode mode, uint32_t interval_ms)
+{
+    switch (mode)
+    {
+    case ESP8266_POWER_MODEM_SLEEP:
+        return _Energy(ESP8266_POWER_MODEM_UA, interval_ms, 0);
+    case ESP8266_POWER_LIGHT_SLEEP:
+        return _Energy(ESP8266_POWER_LIGHT_UA, interval_ms, ESP8266_POWER_LIGHT_WAKE_MS);
+    case ESP8266_POWER_DEEP_SLEEP:
+        return _Energy(ESP8266_POWER_DEEP_UA, interval_ms, ESP8266_POWER_DEEP_WAKE_MS);
+    default:
+        return _Energy(ESP8266_POWER_ACTIVE_UA, interval_ms, 0);
+    }
+}
+
+ESP8266_PowerMode ESP8266_Power_Plan(uint32_t next_tx_ms)
+{
+    ESP8266_PowerMode best = ESP8266_POWER_MODEM_SLEEP;
+    uint32_t best_energy = ESP8266_Power_Energy(best, next_tx_ms);
+
+    if (power.wake_port != NULL && next_tx_ms > ESP8266_POWER_LIGHT_WAKE_MS &&
+        ESP8266_Power_Energy(ESP8266_POWER_LIGHT_SLEEP, next_tx_ms) < best_energy)
+    {
+        best = ESP8266_POWER_LIGHT_SLEEP;
+        best_energy = ESP8266_Power_Energy(best, next_tx_ms);
+    }
+
+    if (power.deep_sleep_wired && next_tx_ms > ESP8266_POWER_DEEP_WAKE_MS &&
+        ESP8266_Power_Energy(ESP8266_POWER_DEEP_SLEEP, next_tx_ms) < best_energy)
+        best = ESP8266_POWER_DEEP_SLEEP;
+
+    return best;
+}
+
+ESP8266_PowerMode ESP8266_Power_Sleep(uint32_t next_tx_ms)
+{
+    if (state != STATE_AWAKE || !ESP8266_AT_Async_Idle())
+        return ESP8266_POWER_ACTIVE;
+
+    ESP8266_PowerMode mode = ESP8266_Power_Plan(next_tx_ms);
+    ESP8266_AT_Arg args[3];
+
+    switch (mode)
+    {
+    case ESP8266_POWER_MODEM_SLEEP:
+        if (module_sleep_mode != 2)
+        {
+            args[0].u = 2;
+            ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SLEEP, ESP8266_AT_SET, args, 1, 0,
+                                       NULL, _SleepModeSet, (void *)2);
+        }
+        return mode;
+
+    case ESP8266_POWER_LIGHT_SLEEP:
+        if (!wakeup_gpio_set)
+        {
+            args[0].u = 1;
+            args[1].u = power.trigger_gpio;
+            args[2].u = power.trigger_level;
+            ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_WAKEUPGPIO, ESP8266_AT_SET, args, 3, 0,
+                                       NULL, _WakeupGpioSet, NULL);
+        }
+        sleep_ms = next_tx_ms - ESP8266_POWER_LIGHT_WAKE_MS;
+        args[0].u = 1;
+        if (!ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SLEEP, ESP8266_AT_SET, args, 1, 0,
+                                        NULL, _Entered, NULL))
+            return ESP8266_POWER_ACTIVE;
+        break;
+
+    case ESP8266_POWER_DEEP_SLEEP:
+        sleep_ms = next_tx_ms - ESP8266_POWER_DEEP_WAKE_MS;
+        if (sleep_ms > ESP8266_AT_GSLP_MAX_MS)
+            sleep_ms = ESP8266_AT_GSLP_MAX_MS;
+        args[0].u = sleep_ms;
+        if (!ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_GSLP, ESP8266_AT_SET, args, 1, 0,
+                                        NULL, _Entered, NULL))
+            return ESP8266_POWER_ACTIVE;
+        // the module is not usable until it has booted again
+        sleep_ms += ESP8266_POWER_DEEP_WAKE_MS;
+        break;
+
+    default:
+        return ESP8266_POWER_ACTIVE;
+    }
+
+    sleeping_in = mode;
+    state = STATE_ENTERING;
+    return mode;
+}
+
+void ESP8266_Power_Wake(void)
+{
+    if (state == STATE_ASLEEP && sleeping_in == ESP8266_POWER_LIGHT_SLEEP)
+        wake_at = HAL_GetTick();
+}
+
+bool ESP8266_Power_Awake(void)
+{
+    return state == STATE_AWAKE;
+}
+
+void ESP8266_Power_Process(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (state == STATE_ASLEEP && (int32_t)(now - wake_at) >= 0)
+    {
+        if (sleeping_in == ESP8266_POWER_LIGHT_SLEEP)
+        {
+            _WakePin(true);
+            settle_start = now;
+            state = STATE_SETTLING;
+        }
+        else
+        {
+            // Deep-sleep ends in a reboot, which the engine has been
+            // expecting since AT+GSLP: nothing set with _CUR survives
+            module_sleep_mode = -1;
+            wakeup_gpio_set = false;
+            _Awake();
+        }
+    }
+    else if (state == STATE_SETTLING && now - settle_start >= ESP8266_AT_WAKE_SETTLE_MS)
+        _Awake();
+}
@@ -0,0 +1,108 @@
+#include "ESP8266_AT_Prof.h"
+
+#ifdef ESP8266_AT_PROFILE
+
+static volatile uint32_t stamps[ESP8266_PROF_POINTS];
+static uint16_t cmd_hist[ESP8266_AT_CMD_COUNT][ESP8266_PROF_CMD_SPANS][ESP8266_PROF_BUCKETS];
+static uint16_t drv_hist[ESP8266_PROF_DRV_SPANS][ESP8266_PROF_BUCKETS];
+static ESP8266_ProfIsrStats isr;
+static uint32_t burst_ticks;
+
+ESP8266_AT_RAMFUNC static void _Count(uint16_t *hist, uint32_t ticks)
+{
+    uint32_t bucket = ticks ? (33 - __builtin_clz(ticks)) / 2 : 0;
+    if (bucket >= ESP8266_PROF_BUCKETS)
+        bucket = ESP8266_PROF_BUCKETS - 1;
+
+    // saturate rather than wrap
+    if (hist[bucket] != UINT16_MAX)
+        hist[bucket]++;
+}
+
+void ESP8266_Prof_Init(void)
+{
+#if defined(__ARM_ARCH)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    memset(cmd_hist, 0, sizeof(cmd_hist));
+    memset(drv_hist, 0, sizeof(drv_hist));
+    memset(&isr, 0, sizeof(isr));
+    isr.isr_min = UINT32_MAX;
+    isr.gap_min = UINT32_MAX;
+}
+
+void ESP8266_Prof_ByteTime(uint32_t ticks)
+{
+    burst_ticks = ticks + ticks / 2;
+}
+
+void ESP8266_Prof_IsrStats(ESP8266_ProfIsrStats *stats)
+{
+    *stats = isr;
+}
+
+ESP8266_AT_RAMFUNC void ESP8266_Prof_Mark(ESP8266_ProfPoint point, ESP8266_AT_CmdId cmd)
+{
+    uint32_t now = ESP8266_PROF_NOW();
+    uint32_t span;
+
+    if (point == ESP8266_PROF_ISR_ENTER)
+    {
+        span = now - stamps[ESP8266_PROF_ISR_ENTER];
+        if (span < burst_ticks)
+        {
+            if (span < isr.gap_min)
+                isr.gap_min = span;
+            if (span > isr.gap_max)
+                isr.gap_max = span;
+            isr.gaps++;
+        }
+    }
+    stamps[point] = now;
+
+    switch (point)
+    {
+    case ESP8266_PROF_FORMAT_END:
+        _Count(cmd_hist[cmd][ESP8266_PROF_SPAN_FORMAT], now - stamps[ESP8266_PROF_FORMAT_BEGIN]);
+        break;
+    case ESP8266_PROF_TX_DONE:
+        _Count(cmd_hist[cmd][ESP8266_PROF_SPAN_TX], now - stamps[ESP8266_PROF_TX_START]);
+        break;
+    case ESP8266_PROF_FIRST_BYTE:
+        _Count(cmd_hist[cmd][ESP8266_PROF_SPAN_FIRST_BYTE], now - stamps[ESP8266_PROF_TX_DONE]);
+        break;
+    case ESP8266_PROF_RESULT:
+        _Count(cmd_hist[cmd][ESP8266_PROF_SPAN_ROUND_TRIP], now - stamps[ESP8266_PROF_TX_START]);
+        break;
+    case ESP8266_PROF_ISR_EXIT:
+        span = now - stamps[ESP8266_PROF_ISR_ENTER];
+        _Count(drv_hist[ESP8266_PROF_SPAN_ISR], span);
+        if (span < isr.isr_min)
+            isr.isr_min = span;
+        if (span > isr.isr_max)
+            isr.isr_max = span;
+        break;
+    default:
+        break;
+    }
+}
+
+void ESP8266_Prof_Parse(uint32_t ticks, uint32_t bytes)
+{
+    if (bytes)
+        _Count(drv_hist[ESP8266_PROF_SPAN_PARSE_BYTE], ticks / bytes);
+}
+
+const uint16_t *ESP8266_Prof_CmdHistogram(ESP8266_AT_CmdId cmd, ESP8266_ProfCmdSpan span)
+{
+    return cmd_hist[cmd][span];
+}
+
+const uint16_t *ESP8266_Prof_DrvHistogram(ESP8266_ProfDrvSpan span)
+{
+    return drv_hist[span];
+}
+
+#endif
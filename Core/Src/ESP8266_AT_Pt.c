@@ -0,0 +1,26 @@
+#include "ESP8266_AT_Pt.h"
+
+static void _Done(ESP8266_AT_Result result, void *ctx)
+{
+    ((ESP8266_AT_Pt *)ctx)->result = result;
+}
+
+bool ESP8266_AT_Pt_Cmd(ESP8266_AT_Pt *pt, ESP8266_AT_CmdId id, uint8_t form,
+                       const ESP8266_AT_Arg *args, uint8_t count, ESP8266_AT_LineHandler on_line)
+{
+    if (pt->result == ESP8266_AT_PT_UNSENT)
+    {
+        if (!ESP8266_AT_Async_SubmitCmd(id, form, args, count, 0, on_line, _Done, pt))
+        {
+            // a full queue frees up, a command that does not format never will
+            char line[ESP8266_AT_ASYNC_CMD_LEN];
+            if (ESP8266_AT_Format(line, sizeof(line) - 1, id, form, args, count) == 0)
+                pt->result = ESP8266_AT_ERROR;
+
+            return pt->result != ESP8266_AT_PT_UNSENT;
+        }
+        pt->result = ESP8266_AT_PENDING;
+    }
+
+    return pt->result != ESP8266_AT_PENDING;
+}
@@ -0,0 +1,53 @@
+#include "ESP8266_AT_Scan.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+// 1 in every byte lane where the word equals the pattern, 0 elsewhere
+#define MATCHES(word, pattern) __UQSUB8(0x01010101U, (word) ^ (pattern))
+#define FIRST_LANE(mask) (__CLZ(__RBIT(mask)) >> 3)
+
+#else
+
+// high bit set in the lowest matching lane; lanes above it may also be
+// flagged falsely, which does not affect the first match
+#define MATCHES(word, pattern)                                      \
+    ((((word) ^ (pattern)) - 0x01010101U) & ~((word) ^ (pattern)) & \
+     0x80808080U)
+#define FIRST_LANE(mask) (__builtin_ctz(mask) >> 3)
+
+#endif
+
+ESP8266_AT_RAMFUNC size_t ESP8266_AT_Scan(const uint8_t *data, size_t len, uint8_t c)
+{
+    uint32_t pattern = c * 0x01010101U;
+    size_t i = 0;
+
+    for (; i + 4 <= len; i += 4)
+    {
+        uint32_t word;
+        memcpy(&word, data + i, 4); // a single unaligned LDR on Cortex-M4
+
+        uint32_t mask = MATCHES(word, pattern);
+        if (mask)
+            return i + FIRST_LANE(mask);
+    }
+
+    for (; i < len; i++)
+    {
+        if (data[i] == c)
+            return i;
+    }
+
+    return len;
+}
+
+size_t ESP8266_AT_ScanBytewise(const uint8_t *data, size_t len, uint8_t c)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (data[i] == c)
+            return i;
+    }
+
+    return len;
+}
@@ -0,0 +1,173 @@
+#include "ESP8266_AT_Sync.h"
+
+#ifdef ESP8266_AT_OS
+
+typedef struct
+{
+    const ESP8266_AT_Arg *args;
+    ESP8266_AT_LineHandler on_line;
+    void *ctx;
+    uint32_t timeout;
+    ESP8266_AT_CmdId id;
+    uint8_t form;
+    uint8_t count;
+    uint8_t prio;
+    uint8_t waiter;
+} Request;
+
+// requests taken from the queue that the engine had no room for yet
+typedef struct
+{
+    Request reqs[ESP8266_AT_SYNC_WAITERS];
+    uint8_t head;
+    uint8_t count;
+} Parked;
+
+static ESP8266_AT_OsMutex lock;
+static ESP8266_AT_OsFlags done_flags; // one per waiter slot
+static ESP8266_AT_OsQueue requests;
+static bool ready;
+
+// under lock
+static uint32_t waiters_busy;
+static ESP8266_AT_SyncStats stats;
+
+// driver task only
+static Request started[ESP8266_AT_SYNC_WAITERS]; // by waiter slot
+static ESP8266_AT_Result results[ESP8266_AT_SYNC_WAITERS];
+static Parked parked[ESP8266_AT_PRIO_COUNT]; // by priority, retried after the next poll
+
+// the engine passes the waiter slot to both handlers
+static void _Line(const char *line, void *ctx)
+{
+    const Request *req = &started[(uintptr_t)ctx];
+
+    if (req->on_line)
+        req->on_line(line, req->ctx);
+}
+
+static void _Done(ESP8266_AT_Result result, void *ctx)
+{
+    uint8_t waiter = (uint8_t)(uintptr_t)ctx;
+
+    results[waiter] = result;
+    ESP8266_AT_Os_FlagsSet(&done_flags, 1UL << waiter);
+}
+
+// false when the engine has no room for it yet
+static bool _Start(const Request *req)
+{
+    started[req->waiter] = *req;
+    if (ESP8266_AT_Async_SubmitPrio(req->prio, req->id, req->form, req->args, req->count,
+                                    req->timeout, _Line, _Done, (void *)(uintptr_t)req->waiter))
+        return true;
+
+    ESP8266_AT_PoolStats pool;
+    ESP8266_AT_Async_SlotStats(&pool);
+    uint16_t limit = pool.count;
+    if (req->prio < ESP8266_AT_PRIO_HIGH)
+        limit -= ESP8266_AT_ASYNC_HIGH_RESERVE;
+    if (pool.used >= limit)
+        return false;
+
+    // room to spare, so the command itself was refused
+    _Done(ESP8266_AT_ERROR, (void *)(uintptr_t)req->waiter);
+    return true;
+}
+
+bool ESP8266_AT_Sync_Init(void)
+{
+    waiters_busy = 0;
+    memset(parked, 0, sizeof(parked));
+    memset(&stats, 0, sizeof(stats));
+
+    ready = ESP8266_AT_Os_MutexInit(&lock) && ESP8266_AT_Os_FlagsInit(&done_flags) &&
+            ESP8266_AT_Os_QueueInit(&requests, sizeof(Request), ESP8266_AT_SYNC_WAITERS);
+
+    return ready;
+}
+
+void ESP8266_AT_Sync_Task(void *arg)
+{
+    (void)arg;
+    for (;;)
+        ESP8266_AT_Sync_Run(ESP8266_AT_SYNC_POLL_MS);
+}
+
+void ESP8266_AT_Sync_Run(uint32_t wait_ms)
+{
+    Request req;
+    uint32_t wait = ESP8266_AT_Async_WorkPending() ? 0 : wait_ms;
+
+    // drain the queue, so a request never waits behind one of lower priority
+    while (ESP8266_AT_Os_QueueGet(&requests, &req, wait))
+    {
+        Parked *lane = &parked[req.prio];
+        // at most one request per waiter slot is outstanding, so it fits
+        lane->reqs[(lane->head + lane->count) % ESP8266_AT_SYNC_WAITERS] = req;
+        lane->count++;
+        wait = 0;
+    }
+
+    for (int prio = ESP8266_AT_PRIO_COUNT - 1; prio >= 0; prio--)
+    {
+        Parked *lane = &parked[prio];
+        while (lane->count > 0 && _Start(&lane->reqs[lane->head]))
+        {
+            lane->head = (lane->head + 1) % ESP8266_AT_SYNC_WAITERS;
+            lane->count--;
+        }
+    }
+
+    ESP8266_AT_Async_Poll();
+}
+
+ESP8266_AT_Result ESP8266_AT_Sync_Cmd(ESP8266_AT_Priority prio, ESP8266_AT_CmdId id, uint8_t form,
+                                      const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                      ESP8266_AT_LineHandler on_line, void *ctx)
+{
+    if (!ready || prio >= ESP8266_AT_PRIO_COUNT)
+        return ESP8266_AT_ERROR;
+
+    uint32_t start = ESP8266_AT_Os_Tick();
+    uint8_t waiter = 0;
+
+    ESP8266_AT_Os_MutexLock(&lock);
+    stats.calls++;
+    while (waiter < ESP8266_AT_SYNC_WAITERS && (waiters_busy & (1UL << waiter)))
+        waiter++;
+    if (waiter < ESP8266_AT_SYNC_WAITERS)
+        waiters_busy |= 1UL << waiter;
+    else
+        stats.no_waiter++;
+    ESP8266_AT_Os_MutexUnlock(&lock);
+
+    if (waiter == ESP8266_AT_SYNC_WAITERS)
+        return ESP8266_AT_ERROR;
+
+    Request req = {args, on_line, ctx, timeout, id, form, count, prio, waiter};
+
+    // the queue holds one request per waiter slot, so it never fills up
+    ESP8266_AT_Os_QueuePut(&requests, &req, ESP8266_AT_OS_FOREVER);
+    ESP8266_AT_Os_FlagsWait(&done_flags, 1UL << waiter, ESP8266_AT_OS_FOREVER);
+    // set before the flag, and the slot is still ours
+    ESP8266_AT_Result result = results[waiter];
+
+    uint32_t waited = ESP8266_AT_Os_Tick() - start;
+    ESP8266_AT_Os_MutexLock(&lock);
+    waiters_busy &= ~(1UL << waiter);
+    if (waited > stats.max_ms)
+        stats.max_ms = waited;
+    ESP8266_AT_Os_MutexUnlock(&lock);
+
+    return result;
+}
+
+void ESP8266_AT_Sync_GetStats(ESP8266_AT_SyncStats *out)
+{
+    ESP8266_AT_Os_MutexLock(&lock);
+    *out = stats;
+    ESP8266_AT_Os_MutexUnlock(&lock);
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "ESP8266_AT_Text.h"
+
+static const char hex[] = "0123456789abcdef";
+
+static inline int8_t _HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20; // lower case
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+uint8_t ESP8266_AT_FormatUint(char *buf, uint32_t value)
+{
+    char digits[ESP8266_AT_UINT_CHARS];
+    uint8_t n = 0;
+
+    // most values sent are below 100: skip the division loop for them
+    if (value < 10)
+    {
+        buf[0] = '0' + value;
+        return 1;
+    }
+    if (value < 100)
+    {
+        buf[0] = '0' + value / 10;
+        buf[1] = '0' + value % 10;
+        return 2;
+    }
+
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    for (uint8_t i = 0; i < n; i++)
+        buf[i] = digits[n - 1 - i];
+
+    return n;
+}
+
+uint8_t ESP8266_AT_FormatInt(char *buf, int32_t value)
+{
+    if (value >= 0)
+        return ESP8266_AT_FormatUint(buf, value);
+
+    buf[0] = '-';
+    return 1 + ESP8266_AT_FormatUint(buf + 1, -(uint32_t)value);
+}
+
+uint8_t ESP8266_AT_FormatIPv4(char *buf, const uint8_t ip[4])
+{
+    uint8_t len = 0;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (i > 0)
+            buf[len++] = '.';
+        len += ESP8266_AT_FormatUint(buf + len, ip[i]);
+    }
+
+    return len;
+}
+
+uint8_t ESP8266_AT_FormatMac(char *buf, const uint8_t mac[6])
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        buf[i * 3] = hex[mac[i] >> 4];
+        buf[i * 3 + 1] = hex[mac[i] & 0x0F];
+        if (i < 5)
+            buf[i * 3 + 2] = ':';
+    }
+
+    return ESP8266_AT_MAC_CHARS;
+}
+
+uint16_t ESP8266_AT_FormatQuoted(char *buf, size_t size, const char *str)
+{
+    size_t len = 0;
+
+    if (size < 2)
+        return 0;
+    buf[len++] = '"';
+
+    for (; *str; str++)
+    {
+        bool escape = *str == '"' || *str == ',' || *str == '\\';
+        // keep room for the closing quote
+        if (len + 1 + escape >= size)
+            return 0;
+        if (escape)
+            buf[len++] = '\\';
+        buf[len++] = *str;
+    }
+
+    buf[len++] = '"';
+    return len;
+}
+
+const char *ESP8266_AT_ParseUint(const char *p, uint32_t *value)
+{
+    uint32_t result = 0;
+    const char *start = p;
+
+    for (; *p >= '0' && *p <= '9'; p++)
+    {
+        uint8_t digit = *p - '0';
+        if (result > (UINT32_MAX - digit) / 10)
+            return NULL;
+        result = result * 10 + digit;
+    }
+
+    if (p == start)
+        return NULL;
+
+    *value = result;
+    return p;
+}
+
+const char *ESP8266_AT_ParseInt(const char *p, int32_t *value)
+{
+    bool negative = *p == '-';
+    uint32_t magnitude;
+
+    p = ESP8266_AT_ParseUint(p + negative, &magnitude);
+    if (p == NULL || magnitude > (uint32_t)INT32_MAX + negative)
+        return NULL;
+
+    *value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+    return p;
+}
+
+const char *ESP8266_AT_ParseIPv4(const char *p, uint8_t ip[4])
+{
+    uint8_t parts[4];
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (i > 0 && *p++ != '.')
+            return NULL;
+
+        uint32_t part;
+        const char *end = ESP8266_AT_ParseUint(p, &part);
+        if (end == NULL || end - p > 3 || part > 255)
+            return NULL;
+        parts[i] = part;
+        p = end;
+    }
+
+    memcpy(ip, parts, 4);
+    return p;
+}
+
+const char *ESP8266_AT_ParseMac(const char *p, uint8_t mac[6])
+{
+    uint8_t bytes[6];
+
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (i > 0 && *p++ != ':')
+            return NULL;
+
+        int8_t high = _HexDigit(p[0]);
+        int8_t low = high < 0 ? -1 : _HexDigit(p[1]);
+        if (low < 0)
+            return NULL;
+        bytes[i] = high << 4 | low;
+        p += 2;
+    }
+
+    memcpy(mac, bytes, 6);
+    return p;
+}
+
+const char *ESP8266_AT_ParseQuoted(const char *p, char *out, size_t size)
+{
+    size_t len = 0;
+
+    if (*p++ != '"')
+        return NULL;
+
+    for (; *p && *p != '"'; p++)
+    {
+        if (*p == '\\' && p[1])
+            p++;
+        if (out && len + 1 < size)
+            out[len++] = *p;
+    }
+
+    if (out && size > 0)
+        out[len] = '\0';
+
+    return *p == '"' ? p + 1 : NULL;
+}
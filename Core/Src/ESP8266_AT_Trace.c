@@ -0,0 +1,53 @@
+#include "ESP8266_AT_Trace.h"
+
+#ifdef ESP8266_AT_TRACE
+
+static ESP8266_TraceEvent ring[ESP8266_TRACE_LEN];
+static volatile uint32_t write_index;
+
+void ESP8266_Trace_Record(ESP8266_TraceDir dir, ESP8266_AT_CmdId cmd, const char *data, uint16_t len)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ESP8266_TraceEvent *event = &ring[write_index & (ESP8266_TRACE_LEN - 1)];
+    write_index++;
+    __set_PRIMASK(primask);
+
+    event->time_ms = HAL_GetTick();
+    event->dir = dir;
+    event->cmd = cmd;
+    event->len = len;
+
+    uint32_t prefix = 0;
+    if (data)
+        memcpy(&prefix, data, len < 4 ? len : 4);
+    memcpy(event->prefix, &prefix, 4);
+}
+
+size_t ESP8266_Trace_Export(uint8_t *buf, size_t len)
+{
+    if (len < 8)
+        return 0;
+
+    uint32_t end = write_index;
+    uint32_t count = end < ESP8266_TRACE_LEN ? end : ESP8266_TRACE_LEN;
+    if (count > (len - 8) / sizeof(ESP8266_TraceEvent))
+        count = (len - 8) / sizeof(ESP8266_TraceEvent);
+
+    buf[0] = 'T';
+    buf[1] = ESP8266_TRACE_VERSION;
+    buf[2] = sizeof(ESP8266_TraceEvent);
+    buf[3] = 0;
+    memcpy(buf + 4, &end, 4);
+
+    uint8_t *out = buf + 8;
+    for (uint32_t i = end - count; i != end; i++)
+    {
+        memcpy(out, &ring[i & (ESP8266_TRACE_LEN - 1)], sizeof(ESP8266_TraceEvent));
+        out += sizeof(ESP8266_TraceEvent);
+    }
+
+    return out - buf;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "ESP8266_AT_Tx.h"
+
+static UART_HandleTypeDef *tx_uart;
+
+static uint8_t tx_buf[2][ESP8266_AT_TX_BUF_LEN];
+static uint8_t fill;            // buffer being filled
+static volatile uint16_t fill_len;
+static volatile bool draining;  // the other buffer is being transmitted
+static volatile bool reserved;
+
+// call with interrupts masked or from the transmit complete interrupt
+static void _Start(void)
+{
+    HAL_StatusTypeDef status;
+
+    if (tx_uart->hdmatx)
+        status = HAL_UART_Transmit_DMA(tx_uart, tx_buf[fill], fill_len);
+    else
+        status = HAL_UART_Transmit_IT(tx_uart, tx_buf[fill], fill_len);
+
+    // the UART is in use elsewhere: the bytes wait for ESP8266_AT_Tx_Kick
+    if (status != HAL_OK)
+        return;
+
+    fill ^= 1;
+    fill_len = 0;
+    draining = true;
+}
+
+void ESP8266_AT_Tx_Init(UART_HandleTypeDef *uart)
+{
+    tx_uart = uart;
+    fill = 0;
+    fill_len = 0;
+    draining = false;
+    reserved = false;
+}
+
+uint8_t *ESP8266_AT_Tx_Reserve(uint16_t len)
+{
+    uint8_t *room = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!reserved && len <= ESP8266_AT_TX_BUF_LEN - fill_len)
+    {
+        room = &tx_buf[fill][fill_len];
+        reserved = true;
+    }
+    __set_PRIMASK(primask);
+
+    return room;
+}
+
+void ESP8266_AT_Tx_Commit(uint16_t len)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    fill_len += len;
+    reserved = false;
+    if (!draining && fill_len > 0)
+        _Start();
+    __set_PRIMASK(primask);
+}
+
+uint16_t ESP8266_AT_Tx_Write(const void *data, uint16_t len)
+{
+    uint16_t room = ESP8266_AT_Tx_Room();
+    if (len > room)
+        len = room;
+    if (len == 0)
+        return 0;
+
+    uint8_t *at = ESP8266_AT_Tx_Reserve(len);
+    if (at == NULL)
+        return 0;
+
+    memcpy(at, data, len);
+    ESP8266_AT_Tx_Commit(len);
+
+    return len;
+}
+
+void ESP8266_AT_Tx_Kick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!draining && !reserved && fill_len > 0)
+        _Start();
+    __set_PRIMASK(primask);
+}
+
+uint16_t ESP8266_AT_Tx_Room(void)
+{
+    return reserved ? 0 : ESP8266_AT_TX_BUF_LEN - fill_len;
+}
+
+bool ESP8266_AT_Tx_Busy(void)
+{
+    return draining || fill_len > 0;
+}
+
+void ESP8266_AT_Tx_Abort(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (draining)
+        HAL_UART_AbortTransmit(tx_uart);
+    fill_len = 0;
+    draining = false;
+    reserved = false;
+    __set_PRIMASK(primask);
+}
+
+void ESP8266_AT_Tx_CpltCallback(UART_HandleTypeDef *uart)
+{
+    if (uart != tx_uart)
+        return;
+
+    draining = false;
+    // an open reservation may still be writing to the fill buffer; its
+    // commit starts the transfer instead
+    if (!reserved && fill_len > 0)
+        _Start();
+}
@@ -0,0 +1,138 @@
+#include "ESP8266_AT_TxPower.h"
+
+static ESP8266_TxPowerConfig control;
+static uint8_t power;
+static uint8_t applied;
+static uint16_t vdd;
+static uint16_t send_failures;
+static uint32_t lost_seen; // LinkMonitor's lost count at the last step
+static uint32_t last_update;
+static bool pending;
+
+static void _PowerSet(ESP8266_AT_Result result, void *ctx)
+{
+    if (result == ESP8266_AT_OK)
+        applied = (uint8_t)(uintptr_t)ctx;
+    pending = false;
+}
+
+static void _Apply(void)
+{
+    if (power == applied)
+    {
+        pending = false;
+        return;
+    }
+
+    ESP8266_AT_Arg args[] = {{.u = power}};
+    if (!ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_RFPOWER, ESP8266_AT_SET, args, 1, 0,
+                                    NULL, _PowerSet, (void *)(uintptr_t)power))
+        pending = false;
+}
+
+static void _Step(void)
+{
+    ESP8266_LinkStats stats;
+    ESP8266_LinkMonitor_GetStats(&stats);
+
+    uint8_t ceiling = control.max_power;
+    if (vdd != 0 && vdd < ESP8266_TXPOWER_LOW_VDD_MV && control.low_vdd_max_power < ceiling)
+        ceiling = control.low_vdd_max_power;
+
+    // loss_pct covers the whole window: one lost ping would keep the
+    // power up for the next ESP8266_LINKMON_WINDOW steps
+    bool new_loss = stats.lost != lost_seen;
+    lost_seen = stats.lost;
+
+    bool degraded = send_failures > 0 || new_loss ||
+                    stats.jitter_ms > control.max_jitter_ms ||
+                    (stats.rssi != 0 && stats.rssi < control.target_rssi);
+    bool margin = stats.rssi != 0 && stats.rssi >= control.target_rssi + control.hysteresis;
+    int16_t next = power;
+
+    if (degraded)
+        next += ESP8266_TXPOWER_STEP_UP;
+    else if (margin && stats.samples > 0)
+        next -= ESP8266_TXPOWER_STEP_DOWN;
+
+    if (next < control.min_power)
+        next = control.min_power;
+    if (next > ceiling)
+        next = ceiling;
+
+    power = next;
+    send_failures = 0;
+}
+
+static void _VddLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    // +RFVDD:<VDD33>
+    int32_t value;
+    if (ESP8266_AT_ParseReply(ESP8266_AT_CMD_RFVDD, line, &value, 1) == 1)
+        vdd = value;
+}
+
+static void _VddDone(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    // the reading is invalid unless TOUT is floating; a failed query
+    // simply leaves the supply unknown
+    if (result != ESP8266_AT_OK || vdd < ESP8266_AT_VDD33_MIN || vdd > ESP8266_AT_VDD33_MAX)
+        vdd = 0;
+
+    _Step();
+    _Apply();
+}
+
+void ESP8266_TxPower_Init(const ESP8266_TxPowerConfig *config)
+{
+    control = *config;
+    if (control.max_power > ESP8266_AT_RFPOWER_MAX)
+        control.max_power = ESP8266_AT_RFPOWER_MAX;
+    if (control.min_power > control.max_power)
+        control.min_power = control.max_power;
+
+    power = control.max_power;
+    applied = 0xFF;
+    vdd = 0;
+    send_failures = 0;
+    ESP8266_LinkStats stats;
+    ESP8266_LinkMonitor_GetStats(&stats);
+    lost_seen = stats.lost;
+    last_update = HAL_GetTick();
+    pending = true;
+    _Apply();
+}
+
+void ESP8266_TxPower_ReportSend(bool ok)
+{
+    if (!ok && send_failures < UINT16_MAX)
+        send_failures++;
+}
+
+void ESP8266_TxPower_Process(void)
+{
+    if (pending || HAL_GetTick() - last_update < control.period_ms)
+        return;
+
+    last_update = HAL_GetTick();
+    if (ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_RFVDD, ESP8266_AT_QUERY, NULL, 0, 0,
+                                   _VddLine, _VddDone, NULL))
+        pending = true;
+}
+
+void ESP8266_TxPower_Invalidate(void)
+{
+    applied = 0xFF;
+}
+
+uint8_t ESP8266_TxPower_Get(void)
+{
+    return power;
+}
+
+uint16_t ESP8266_TxPower_Vdd(void)
+{
+    return vdd;
+}
@@ -21,6 +21,15 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "ESP8266_AT_Async.h"
+#include "ESP8266_AT_Idle.h"
+#include "ESP8266_AT_Keyword.h"
+#include "ESP8266_AT_Prof.h"
+#include "ESP8266_AT_Scan.h"
+#include "ESP8266_AT_Text.h"
+#ifdef ESP8266_AT_BENCH
+#include <stdio.h>
+#endif
 
 /* USER CODE END Includes */
 
@@ -41,16 +50,39 @@
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* USER CODE BEGIN PV */
+static ClockProfile clock_profile = CLOCK_PROFILE_HSI_16MHZ;
+#ifdef ESP8266_AT_BENCH
+/* parser cost per profile, in CPU cycles per 1000 received bytes */
+volatile uint32_t parser_bench_cycles[3];
+/* end of line search over the capture: bytewise, word at a time */
+volatile uint32_t scan_bench_cycles[2];
+/* keyword lookup per line: strncmp chain, hashed */
+volatile uint32_t keyword_bench_cycles[2];
+/* integer, IPv4 and MAC per call: snprintf, primitives, sscanf, primitives */
+volatile uint32_t text_bench_cycles[4];
+/* receive interrupt: duration min/max, entry spacing min/max. Build with
+   and without ESP8266_AT_RAM_ISR to compare flash and SRAM execution */
+volatile uint32_t isr_bench_cycles[4];
+#endif
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
+#ifdef ESP8266_AT_BENCH
+static void Parser_Benchmark(void);
+static void Text_Benchmark(uint32_t rounds);
+#ifdef ESP8266_AT_PROFILE
+static void Isr_Benchmark(void);
+#endif
+#endif
 
 /* USER CODE END PFP */
 
@@ -82,13 +114,32 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  SystemClock_ConfigProfile(CLOCK_PROFILE);
 
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
+#ifdef ESP8266_AT_PROFILE
+  ESP8266_Prof_Init();
+  ESP8266_Prof_ByteTime((uint64_t)SystemCoreClock * 10 / huart1.Init.BaudRate);
+#endif
+  if (!ESP8266_AT_Async_Init(&huart1))
+  {
+    Error_Handler();
+  }
+  ESP8266_Idle_Init(GPIOA, GPIO_PIN_10, SystemClock_Restore);
+#ifdef ESP8266_AT_BENCH
+  Parser_Benchmark();
+#ifdef ESP8266_AT_PROFILE
+  Isr_Benchmark();
+#endif
+#endif
+  /* the module powers up with the MCU: hold commands until it is ready */
+  ESP8266_AT_Boot_Start();
 
   /* USER CODE END 2 */
 
@@ -99,6 +150,8 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    ESP8266_AT_Async_Poll();
+    ESP8266_Idle_Enter(false);
   }
   /* USER CODE END 3 */
 }
@@ -177,6 +230,22 @@ static void MX_USART1_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA2_Stream7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -195,6 +264,343 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief Switches the system clock to one of the predefined profiles,
+  *        setting voltage scale, over-drive, flash latency and the ART
+  *        accelerator to match. The UARTs must be reclocked afterwards.
+  * @param profile: clock profile to apply
+  * @retval None
+  */
+void SystemClock_ConfigProfile(ClockProfile profile)
+{
+  RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+  RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+  RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
+  uint32_t latency = FLASH_LATENCY_0;
+
+  /** Run from the HSI while the PLL and the regulator are changed
+  */
+  RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
+                              |RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+  RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
+  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+  if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, __HAL_FLASH_GET_LATENCY()) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+  RCC_OscInitStruct.HSIState = RCC_HSI_ON;
+  RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+  RCC_OscInitStruct.PLL.PLLState = RCC_PLL_OFF;
+  if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (__HAL_PWR_GET_FLAG(PWR_FLAG_ODRDY))
+  {
+    HAL_PWREx_DisableOverDrive();
+  }
+
+  RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+  RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+  RCC_OscInitStruct.PLL.PLLR = 2;
+  switch (profile)
+  {
+  case CLOCK_PROFILE_PLL_84MHZ:
+    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
+    RCC_OscInitStruct.PLL.PLLM = 16;
+    RCC_OscInitStruct.PLL.PLLN = 336;
+    RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV4;
+    RCC_OscInitStruct.PLL.PLLQ = 7;
+    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;
+    latency = FLASH_LATENCY_2;
+    break;
+
+  case CLOCK_PROFILE_PLL_180MHZ:
+    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
+    RCC_OscInitStruct.PLL.PLLM = 8;
+    RCC_OscInitStruct.PLL.PLLN = 180;
+    RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV2;
+    /* 360 MHz VCO: no PLLQ gives 48 MHz, PLL48CLK comes from PLLSAI below */
+    RCC_OscInitStruct.PLL.PLLQ = 8;
+    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV4;
+    RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV2;
+    latency = FLASH_LATENCY_5;
+    break;
+
+  default:
+    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
+    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+    break;
+  }
+
+  if (RCC_OscInitStruct.PLL.PLLState == RCC_PLL_ON)
+  {
+    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    {
+      Error_Handler();
+    }
+    if (profile == CLOCK_PROFILE_PLL_180MHZ && HAL_PWREx_EnableOverDrive() != HAL_OK)
+    {
+      Error_Handler();
+    }
+    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+  }
+
+  /** PLL48CLK for USB OTG FS, SDIO and RNG: PLLQ in the 84 MHz profile,
+  * PLLSAI at HSI / 8 * 96 / 4 in the 180 MHz one. Stop turns PLLSAI off
+  * too, so it is set up again on every call
+  */
+  PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_CLK48;
+  PeriphClkInitStruct.Clk48ClockSelection = RCC_CLK48CLKSOURCE_PLLQ;
+  if (profile == CLOCK_PROFILE_PLL_180MHZ)
+  {
+    PeriphClkInitStruct.PLLSAI.PLLSAIM = 8;
+    PeriphClkInitStruct.PLLSAI.PLLSAIN = 96;
+    PeriphClkInitStruct.PLLSAI.PLLSAIP = RCC_PLLSAIP_DIV4;
+    PeriphClkInitStruct.PLLSAI.PLLSAIQ = 2;
+    PeriphClkInitStruct.Clk48ClockSelection = RCC_CLK48CLKSOURCE_PLLSAIP;
+  }
+  if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (profile != CLOCK_PROFILE_PLL_180MHZ)
+  {
+    __HAL_RCC_PLLSAI_DISABLE();
+  }
+
+  /** Flush the ART caches around the latency change; prefetch only pays
+  * off with wait states
+  */
+  __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+  __HAL_FLASH_DATA_CACHE_DISABLE();
+  if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, latency) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+  __HAL_FLASH_DATA_CACHE_RESET();
+  __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+  __HAL_FLASH_DATA_CACHE_ENABLE();
+  if (latency == FLASH_LATENCY_0)
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+  }
+  else
+  {
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+  }
+
+  clock_profile = profile;
+}
+
+/**
+  * @brief Re-applies the active clock profile, e.g. after Stop mode
+  * @retval None
+  */
+void SystemClock_Restore(void)
+{
+  SystemClock_ConfigProfile(clock_profile);
+}
+
+#ifdef ESP8266_AT_BENCH
+/**
+  * @brief Measures the RX parser in every clock profile. Results are
+  *        left in parser_bench_cycles for the debugger.
+  * @retval None
+  */
+static void Parser_Benchmark(void)
+{
+  static const char capture[] =
+    "+CWLAP:(3,\"HomeNet\",-61,\"a4:2b:b0:c1:22:10\",6,-8,0)\r\n"
+    "+CWLAP:(4,\"Office-5G\",-77,\"3c:52:82:0e:91:af\",11,-12,0)\r\n"
+    "+IPD,0,24:GET /status HTTP/1.1\r\n\r\n"
+    "SEND OK\r\n"
+    "OK\r\n";
+  const uint32_t rounds = 100;
+  ClockProfile active = clock_profile;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  for (uint32_t profile = 0; profile < 3; profile++)
+  {
+    SystemClock_ConfigProfile((ClockProfile)profile);
+    ESP8266_AT_Async_Reclock();
+
+    uint32_t start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+      ESP8266_AT_Async_Feed((const uint8_t *)capture, sizeof(capture) - 1);
+      ESP8266_AT_Async_Poll();
+    }
+    parser_bench_cycles[profile] = (uint64_t)(DWT->CYCCNT - start) * 1000 / (rounds * (sizeof(capture) - 1));
+  }
+
+  SystemClock_ConfigProfile(active);
+  ESP8266_AT_Async_Reclock();
+
+  size_t (*const scanners[2])(const uint8_t *, size_t, uint8_t) = {
+    ESP8266_AT_ScanBytewise, ESP8266_AT_Scan
+  };
+  for (uint32_t s = 0; s < 2; s++)
+  {
+    volatile size_t sink = 0;
+    uint32_t start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+      /* walk the capture line by line as the parser does */
+      const uint8_t *p = (const uint8_t *)capture;
+      size_t left = sizeof(capture) - 1;
+      while (left)
+      {
+        size_t at = scanners[s](p, left, '\n');
+        at += at < left;
+        p += at;
+        left -= at;
+        sink += at;
+      }
+    }
+    scan_bench_cycles[s] = DWT->CYCCNT - start;
+    (void)sink;
+  }
+
+  /* lines in the proportions a connected station sees them */
+  static const char *const lines[] = {
+    "OK", "OK", "OK", "SEND OK", "Recv 24 bytes", "+IPD,0,24:GET /status HTTP/1.1",
+    "+CWLAP:(3,\"HomeNet\",-61,\"a4:2b:b0:c1:22:10\",6,-8,0)", "+SYSRAM:41232",
+    "+CIPSTATUS:0,\"TCP\",\"192.168.1.20\",80,51234,0", "STATUS:3", "0,CONNECT",
+    "0,CLOSED", "WIFI GOT IP", "busy p...", "ERROR", "AT+CIPSEND=0,24"
+  };
+  uint8_t lengths[sizeof(lines) / sizeof(lines[0])];
+  for (uint32_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++)
+    lengths[l] = strlen(lines[l]);
+
+  ESP8266_AT_KeywordId (*const matchers[2])(const char *, uint16_t) = {
+    ESP8266_AT_Keyword_MatchLinear, ESP8266_AT_Keyword_Match
+  };
+  for (uint32_t m = 0; m < 2; m++)
+  {
+    volatile uint32_t sink = 0;
+    uint32_t start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+      for (uint32_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++)
+        sink += matchers[m](lines[l], lengths[l]);
+    }
+    keyword_bench_cycles[m] = (DWT->CYCCNT - start) / (rounds * (sizeof(lines) / sizeof(lines[0])));
+    (void)sink;
+  }
+
+  Text_Benchmark(rounds);
+}
+
+/**
+  * @brief Formats and parses "115200,192.168.1.20,a4:2b:b0:c1:22:10"
+  *        with the C library and with the ESP8266_AT_Text primitives.
+  *        Results are left in text_bench_cycles.
+  * @retval None
+  */
+static void Text_Benchmark(uint32_t rounds)
+{
+  static const char line[] = "115200,192.168.1.20,a4:2b:b0:c1:22:10";
+  static const uint8_t ip[4] = {192, 168, 1, 20};
+  static const uint8_t mac[6] = {0xa4, 0x2b, 0xb0, 0xc1, 0x22, 0x10};
+  char buf[48];
+  volatile uint32_t sink = 0;
+  uint32_t start;
+
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < rounds; i++)
+    sink += snprintf(buf, sizeof(buf), "%lu,%u.%u.%u.%u,%02x:%02x:%02x:%02x:%02x:%02x",
+                     115200UL + i, ip[0], ip[1], ip[2], ip[3],
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  text_bench_cycles[0] = (DWT->CYCCNT - start) / rounds;
+
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < rounds; i++)
+  {
+    uint8_t n = ESP8266_AT_FormatUint(buf, 115200 + i);
+    buf[n++] = ',';
+    n += ESP8266_AT_FormatIPv4(buf + n, ip);
+    buf[n++] = ',';
+    n += ESP8266_AT_FormatMac(buf + n, mac);
+    sink += n;
+  }
+  text_bench_cycles[1] = (DWT->CYCCNT - start) / rounds;
+
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < rounds; i++)
+  {
+    unsigned long baud;
+    unsigned q[4], m[6];
+    sink += sscanf(line, "%lu,%u.%u.%u.%u,%x:%x:%x:%x:%x:%x", &baud, &q[0], &q[1], &q[2], &q[3],
+                   &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]);
+  }
+  text_bench_cycles[2] = (DWT->CYCCNT - start) / rounds;
+
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < rounds; i++)
+  {
+    uint32_t baud;
+    uint8_t q[4], m[6];
+    const char *p = ESP8266_AT_ParseUint(line, &baud);
+    p = ESP8266_AT_ParseIPv4(p + 1, q);
+    p = ESP8266_AT_ParseMac(p + 1, m);
+    sink += p != NULL;
+  }
+  text_bench_cycles[3] = (DWT->CYCCNT - start) / rounds;
+  (void)sink;
+}
+
+#ifdef ESP8266_AT_PROFILE
+/**
+  * @brief Has the module send its version banner a few times, a burst
+  *        of back-to-back bytes, and keeps the receive interrupt figures
+  *        in isr_bench_cycles. Needs the module connected.
+  * @retval None
+  */
+static void Isr_Benchmark(void)
+{
+  ESP8266_ProfIsrStats stats;
+
+  ESP8266_Prof_Init();
+  ESP8266_Prof_ByteTime((uint64_t)SystemCoreClock * 10 / huart1.Init.BaudRate);
+
+  for (uint32_t i = 0; i < 8; i++)
+  {
+    ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_GMR, ESP8266_AT_EXEC, NULL, 0, 0, NULL, NULL, NULL);
+    while (!ESP8266_AT_Async_Idle())
+      ESP8266_AT_Async_Poll();
+  }
+
+  ESP8266_Prof_IsrStats(&stats);
+  isr_bench_cycles[0] = stats.isr_min;
+  isr_bench_cycles[1] = stats.isr_max;
+  isr_bench_cycles[2] = stats.gap_min;
+  isr_bench_cycles[3] = stats.gap_max;
+}
+#endif
+#endif
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  ESP8266_AT_Async_TxCpltCallback(huart);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  ESP8266_AT_Async_RxCpltCallback(huart);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  ESP8266_AT_Async_ErrorCallback(huart);
+}
 
 /* USER CODE END 4 */
 
@@ -0,0 +1,109 @@
+/**
+ * stm32f4xx_hal.h
+ * Host stand-in for the HAL header, so the driver modules build on
+ * Linux. It declares the types, registers and functions they use;
+ * the tests link their own fakes for the functions those modules call,
+ * or Hal_Host.c for the async engine.
+ */
+
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    HAL_OK,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    volatile uint32_t SR;
+    volatile uint32_t DR;
+    volatile uint32_t BRR;
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t CR3;
+    volatile uint32_t GTPR;
+} USART_TypeDef;
+
+extern USART_TypeDef Hal_Host_Usart[2];
+#define USART1 (&Hal_Host_Usart[0])
+#define USART6 (&Hal_Host_Usart[1])
+
+#define USART_SR_PE (1U << 0)
+#define USART_SR_FE (1U << 1)
+#define USART_SR_NE (1U << 2)
+#define USART_SR_ORE (1U << 3)
+#define USART_SR_RXNE (1U << 5)
+#define USART_SR_TC (1U << 6)
+#define USART_SR_TXE (1U << 7)
+#define USART_CR1_TCIE (1U << 6)
+#define USART_CR1_TXEIE (1U << 7)
+
+#define UART_OVERSAMPLING_16 0x00000000U
+#define UART_OVERSAMPLING_8 0x00008000U
+
+typedef enum
+{
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00U
+#define HAL_UART_ERROR_ORE 0x08U
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct UART_HandleTypeDef
+{
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    void *hdmatx; // NULL: transmit by interrupt
+    volatile HAL_UART_StateTypeDef gState;
+    volatile HAL_UART_StateTypeDef RxState;
+    volatile uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len,
+                                    uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data,
+                                       uint16_t len);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data,
+                                        uint16_t len);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart); // defined by the application
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+// the host runs single threaded: masking interrupts is a no-op
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t mask)
+{
+    (void)mask;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * Test_KV.c
+ * ESP8266_AT_KV against a simulated flash array. Programming may only
+ * clear bits, as on the STM32, and power can fail before any word: the
+ * word being written is left with a random part of its bits cleared and
+ * the store is mounted again. It must then hold either the state before
+ * the interrupted Set or Delete or the state after it.
+ */
+
+#include "ESP8266_AT_KV.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BANK_SIZE 8192
+#define KEYS ESP8266_AT_KV_KEYS
+#define OPS 200000
+#define NEVER 0xFFFFFFFFU // power budget that does not run out
+
+#define CHECK(cond)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                       \
+        }                                                                  \
+    } while (0)
+
+static uint32_t banks[2][BANK_SIZE / 4];
+static uint32_t budget;     // words left to program before power fails
+static jmp_buf power_fail;
+static uint32_t power_fails;
+
+// spends one word of the budget, or fails power, tearing <word> if any
+static void _Spend(uint32_t *word, uint32_t value)
+{
+    if (budget == NEVER)
+        return;
+    if (budget > 0)
+    {
+        budget--;
+        return;
+    }
+
+    if (word)
+        *word &= value | (uint32_t)rand();
+    power_fails++;
+    longjmp(power_fail, 1);
+}
+
+static bool _Erase(uint8_t bank)
+{
+    // an interrupted erase leaves any mix of erased and old words
+    if (budget == 0)
+        for (uint32_t i = 0; i < BANK_SIZE / 4; i++)
+            if (rand() % 2)
+                banks[bank][i] = 0xFFFFFFFFU;
+    _Spend(NULL, 0);
+
+    memset(banks[bank], 0xFF, sizeof(banks[bank]));
+    return true;
+}
+
+static bool _Program(uint8_t bank, uint32_t offset, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+
+    CHECK(offset % 4 == 0 && len % 4 == 0 && offset + len <= BANK_SIZE);
+    for (uint32_t i = 0; i < len; i += 4)
+    {
+        uint32_t *word = &banks[bank][(offset + i) / 4];
+        uint32_t value;
+        memcpy(&value, bytes + i, sizeof(value));
+
+        // a bit set in <value> but clear in flash cannot be programmed back
+        CHECK((*word & value) == value);
+        _Spend(word, value);
+        *word = value;
+    }
+
+    return true;
+}
+
+static const ESP8266_AT_FlashOps sim = {
+    .size = BANK_SIZE,
+    .base = {(const uint8_t *)banks[0], (const uint8_t *)banks[1]},
+    .erase = _Erase,
+    .program = _Program,
+};
+
+typedef struct
+{
+    uint16_t len[KEYS]; // 0 when unset
+    uint8_t value[KEYS][ESP8266_AT_KV_VALUE_MAX];
+} Model;
+
+static bool _Matches(const Model *model)
+{
+    uint8_t buf[ESP8266_AT_KV_VALUE_MAX];
+
+    for (uint16_t key = 0; key < KEYS; key++)
+    {
+        int16_t len = ESP8266_AT_KV_Get(key, buf, sizeof(buf));
+        if (model->len[key] == 0 ? len != -1
+                                 : len != model->len[key] ||
+                                       memcmp(buf, model->value[key], len) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+// one random Set or Delete, applied to <after> when the store takes it
+static void _Op(Model *after)
+{
+    uint16_t key = rand() % KEYS;
+
+    if (rand() % 5 == 0)
+    {
+        after->len[key] = 0;
+        CHECK(ESP8266_AT_KV_Delete(key));
+        return;
+    }
+
+    uint16_t len = 1 + rand() % ESP8266_AT_KV_VALUE_MAX;
+    after->len[key] = len;
+    for (uint16_t i = 0; i < len; i++)
+        after->value[key][i] = rand() % 4 ? (uint8_t)rand() : 0xFF;
+    CHECK(ESP8266_AT_KV_Set(key, after->value[key], len));
+}
+
+static void _TestPowerFail(void)
+{
+    // static: longjmp may leave locals stale
+    static Model before, after;
+    static uint32_t op;
+
+    memset(banks, 0xFF, sizeof(banks));
+    budget = NEVER;
+    CHECK(ESP8266_AT_KV_Init(&sim));
+    memset(&before, 0, sizeof(before));
+
+    for (op = 0; op < OPS; op++)
+    {
+        after = before;
+        budget = rand() % 8 ? NEVER : (uint32_t)rand() % (rand() % 2 ? 40 : 1200);
+
+        if (setjmp(power_fail) == 0)
+        {
+            _Op(&after);
+            budget = NEVER;
+            CHECK(_Matches(&after));
+            before = after;
+            continue;
+        }
+
+        budget = NEVER;
+        CHECK(ESP8266_AT_KV_Init(&sim));
+        if (_Matches(&after))
+            before = after;
+        else
+            CHECK(_Matches(&before));
+    }
+
+    // and a clean mount sees the same
+    CHECK(ESP8266_AT_KV_Init(&sim));
+    CHECK(_Matches(&before));
+
+    ESP8266_AT_KVStats stats;
+    ESP8266_AT_KV_GetStats(&stats);
+    printf("  %u ops, %u power fails, %u bank moves\n", (unsigned)OPS, (unsigned)power_fails,
+           (unsigned)stats.sequence);
+    CHECK(power_fails > 0 && stats.sequence > 1);
+}
+
+int main(void)
+{
+    srand(1);
+    _TestPowerFail();
+
+    return 0;
+}
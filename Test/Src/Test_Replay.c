@@ -0,0 +1,148 @@
+/**
+ * Test_Replay.c
+ * Plays Data/Session.cap, a capture of the module's side of a short
+ * session at 115200 baud, through ESP8266_AT_Capture_Replay and the
+ * whole async engine. At the captured pace the commands the session
+ * answers must each complete with OK and get their lines; flat out,
+ * the parser must keep above REPLAY_MIN_KBPS, so a change that slows
+ * it down fails here rather than on the bench.
+ */
+
+#include "ESP8266_AT_Capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef REPLAY_CAPTURE
+#define REPLAY_CAPTURE "Data/Session.cap"
+#endif
+// a fifth of the 100 MB/s or so a desktop core reaches at -O2, so that
+// only a real regression trips it; override with make REPLAY_MIN_KBPS=<n>
+#ifndef REPLAY_MIN_KBPS
+#define REPLAY_MIN_KBPS 20000
+#endif
+#define REPLAY_RUNS 500
+#define SESSION_APS 16
+
+#define CHECK(cond)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                       \
+        }                                                                  \
+    } while (0)
+
+extern uint32_t Hal_Host_TxBytes;
+
+static UART_HandleTypeDef uart = {
+    .Instance = USART1,
+    .Init = {.BaudRate = 115200},
+    .gState = HAL_UART_STATE_READY,
+    .RxState = HAL_UART_STATE_READY,
+};
+
+static uint8_t capture[ESP8266_CAPTURE_LEN];
+static size_t capture_len;
+static uint32_t done_ok;
+static uint32_t done_other;
+static uint32_t ap_lines;
+
+// the application's part of the HAL callbacks, as in main.c
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    ESP8266_AT_Async_TxCpltCallback(huart);
+}
+
+// the replayed session never saves defaults
+void ESP8266_AT_Defaults_Forget(void)
+{
+}
+
+static void _Load(void)
+{
+    FILE *file = fopen(REPLAY_CAPTURE, "rb");
+    CHECK(file != NULL);
+    capture_len = fread(capture, 1, sizeof(capture), file);
+    fclose(file);
+    CHECK(capture_len > ESP8266_CAPTURE_HEADER_LEN && capture_len < sizeof(capture));
+}
+
+static void _Done(ESP8266_AT_Result result, void *ctx)
+{
+    (void)ctx;
+    if (result == ESP8266_AT_OK)
+        done_ok++;
+    else
+        done_other++;
+}
+
+static void _ApLine(const char *line, void *ctx)
+{
+    (void)ctx;
+    if (strncmp(line, "+CWLAP:", 7) == 0)
+        ap_lines++;
+}
+
+static void _TestRealTime(void)
+{
+    ESP8266_AT_Arg host = {.s = "example.com"};
+    ESP8266_ReplayStats stats;
+
+    CHECK(ESP8266_AT_Async_Init(&uart));
+
+    // what the session answers, in order
+    CHECK(ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_AT, ESP8266_AT_EXEC, NULL, 0, 0, NULL, _Done,
+                                     NULL));
+    CHECK(ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_GMR, ESP8266_AT_EXEC, NULL, 0, 0, NULL, _Done,
+                                     NULL));
+    CHECK(ESP8266_AT_Async_Submit("AT+CWLAP", 5000, _ApLine, _Done, NULL));
+    CHECK(ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_CWJAP_CUR, ESP8266_AT_QUERY, NULL, 0, 0, NULL,
+                                     _Done, NULL));
+    CHECK(ESP8266_AT_Async_Submit("AT+CIFSR", 1000, NULL, _Done, NULL));
+    CHECK(ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_PING, ESP8266_AT_SET, &host, 1, 0, NULL, _Done,
+                                     NULL));
+    CHECK(ESP8266_AT_Async_SubmitCmd(ESP8266_AT_CMD_SYSRAM, ESP8266_AT_QUERY, NULL, 0, 0, NULL,
+                                     _Done, NULL));
+
+    CHECK(ESP8266_Capture_Replay(capture, capture_len, true, &stats));
+    ESP8266_AT_Async_Poll();
+
+    printf("  real time: %u bytes in %u ms, %u sent\n", (unsigned)stats.bytes,
+           (unsigned)(stats.cycles / 1000000), (unsigned)Hal_Host_TxBytes);
+    CHECK(stats.dropped == 0);
+    CHECK(done_ok == 7 && done_other == 0);
+    CHECK(ap_lines == SESSION_APS);
+    CHECK(ESP8266_AT_Async_Idle());
+}
+
+static void _TestFlatOut(void)
+{
+    ESP8266_ReplayStats stats;
+    uint64_t bytes = 0, ns = 0;
+
+    CHECK(ESP8266_AT_Async_Init(&uart));
+    for (int run = 0; run < REPLAY_RUNS; run++)
+    {
+        CHECK(ESP8266_Capture_Replay(capture, capture_len, false, &stats));
+        CHECK(stats.dropped == 0);
+        bytes += stats.bytes;
+        ns += stats.cycles;
+    }
+
+    // bytes per ms is kB/s
+    uint64_t kbps = bytes * 1000000 / (ns ? ns : 1);
+    printf("  flat out: %llu bytes in %llu us, %llu kB/s, floor %u kB/s\n",
+           (unsigned long long)bytes, (unsigned long long)(ns / 1000), (unsigned long long)kbps,
+           (unsigned)REPLAY_MIN_KBPS);
+    CHECK(kbps >= REPLAY_MIN_KBPS);
+}
+
+int main(void)
+{
+    _Load();
+    _TestRealTime();
+    _TestFlatOut();
+
+    return 0;
+}
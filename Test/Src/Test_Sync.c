@@ -0,0 +1,243 @@
+/**
+ * Test_Sync.c
+ * ESP8266_AT_Sync over the pthread backend, against a fake engine that
+ * stands in for ESP8266_AT_Async: a HIGH request must get past NORMAL
+ * ones the full engine refused, and many tasks calling at once must
+ * each get their own result and lines back.
+ */
+
+#include "ESP8266_AT_Sync.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FAKE_RECORDS 4
+#define WORKERS ESP8266_AT_SYNC_WAITERS
+#define CALLS 5000
+
+#define CHECK(cond)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                       \
+        }                                                                  \
+    } while (0)
+
+typedef struct
+{
+    ESP8266_AT_Priority prio;
+    ESP8266_AT_CmdId id;
+    uint32_t value;
+    ESP8266_AT_LineHandler on_line;
+    ESP8266_AT_DoneHandler on_done;
+    void *ctx;
+} FakeCmd;
+
+// touched by the driver only
+static FakeCmd fake[FAKE_RECORDS];
+static int fake_count;
+static volatile bool fake_hold; // completes nothing while set
+
+// a command sent as ESP8266_AT_EXEC is refused, like one that does not format
+bool ESP8266_AT_Async_SubmitPrio(ESP8266_AT_Priority prio, ESP8266_AT_CmdId id, uint8_t form,
+                                 const ESP8266_AT_Arg *args, uint8_t count, uint32_t timeout,
+                                 ESP8266_AT_LineHandler on_line, ESP8266_AT_DoneHandler on_done,
+                                 void *ctx)
+{
+    (void)count;
+    (void)timeout;
+    int limit = FAKE_RECORDS - (prio < ESP8266_AT_PRIO_HIGH ? ESP8266_AT_ASYNC_HIGH_RESERVE : 0);
+    if (form == ESP8266_AT_EXEC || fake_count >= limit)
+        return false;
+
+    fake[fake_count++] = (FakeCmd){prio, id, args[0].u, on_line, on_done, ctx};
+    return true;
+}
+
+void ESP8266_AT_Async_SlotStats(ESP8266_AT_PoolStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->count = FAKE_RECORDS;
+    stats->used = fake_count;
+}
+
+bool ESP8266_AT_Async_WorkPending(void)
+{
+    return fake_count > 0;
+}
+
+// completes the oldest command of the highest priority, now and then
+void ESP8266_AT_Async_Poll(void)
+{
+    if (fake_hold || fake_count == 0 || rand() % 3)
+        return;
+
+    int pick = 0;
+    for (int i = 1; i < fake_count; i++)
+        if (fake[i].prio > fake[pick].prio)
+            pick = i;
+
+    FakeCmd cmd = fake[pick];
+    memmove(&fake[pick], &fake[pick + 1], (fake_count - pick - 1) * sizeof(FakeCmd));
+    fake_count--;
+
+    char line[16];
+    snprintf(line, sizeof(line), "%u", (unsigned)cmd.value);
+    if (cmd.on_line)
+        cmd.on_line(line, cmd.ctx);
+    cmd.on_done(cmd.id % 2 ? ESP8266_AT_OK : ESP8266_AT_TIMEOUT, cmd.ctx);
+}
+
+static ESP8266_AT_Result _Expected(ESP8266_AT_CmdId id)
+{
+    return id % 2 ? ESP8266_AT_OK : ESP8266_AT_TIMEOUT;
+}
+
+static int failures;
+static int finished;
+
+static void _Fail(void)
+{
+    __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+}
+
+static void _Line(const char *line, void *ctx)
+{
+    if ((uint32_t)strtoul(line, NULL, 10) != *(uint32_t *)ctx)
+        _Fail();
+}
+
+typedef struct
+{
+    pthread_t thread;
+    ESP8266_AT_Priority prio;
+    uint32_t value;
+} OneCall;
+
+static void *_OneCall(void *arg)
+{
+    OneCall *call = arg;
+    ESP8266_AT_Arg args[1] = {{.u = call->value}};
+
+    if (ESP8266_AT_Sync_Cmd(call->prio, ESP8266_AT_CMD_AT, ESP8266_AT_SET, args, 1, 0, _Line,
+                            &call->value) != _Expected(ESP8266_AT_CMD_AT))
+        _Fail();
+    __atomic_add_fetch(&finished, 1, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+// runs the driver from this thread for about <ms>, or until <done>
+static void _Drive(uint32_t ms, bool (*done)(void))
+{
+    uint32_t start = ESP8266_AT_Os_Tick();
+
+    while (ESP8266_AT_Os_Tick() - start < ms && !(done && done()))
+        ESP8266_AT_Sync_Run(1);
+}
+
+static bool _HighStarted(void)
+{
+    for (int i = 0; i < fake_count; i++)
+        if (fake[i].prio == ESP8266_AT_PRIO_HIGH)
+            return true;
+
+    return false;
+}
+
+static bool _AllFinished(void)
+{
+    return __atomic_load_n(&finished, __ATOMIC_RELAXED) == FAKE_RECORDS + 1;
+}
+
+static void _TestHighPassesParked(void)
+{
+    OneCall calls[FAKE_RECORDS + 1];
+
+    // one more NORMAL request than the engine takes, so one is parked
+    fake_hold = true;
+    for (int i = 0; i < FAKE_RECORDS; i++)
+    {
+        calls[i] = (OneCall){.prio = ESP8266_AT_PRIO_NORMAL, .value = i};
+        pthread_create(&calls[i].thread, NULL, _OneCall, &calls[i]);
+    }
+    _Drive(100, NULL);
+    CHECK(fake_count == FAKE_RECORDS - ESP8266_AT_ASYNC_HIGH_RESERVE);
+
+    calls[FAKE_RECORDS] = (OneCall){.prio = ESP8266_AT_PRIO_HIGH, .value = FAKE_RECORDS};
+    pthread_create(&calls[FAKE_RECORDS].thread, NULL, _OneCall, &calls[FAKE_RECORDS]);
+    _Drive(1000, _HighStarted);
+    CHECK(_HighStarted());
+
+    fake_hold = false;
+    _Drive(5000, _AllFinished);
+    CHECK(_AllFinished());
+    for (int i = 0; i <= FAKE_RECORDS; i++)
+        pthread_join(calls[i].thread, NULL);
+    CHECK(failures == 0);
+}
+
+static volatile bool stop;
+
+static void *_Driver(void *arg)
+{
+    (void)arg;
+    while (!stop)
+        ESP8266_AT_Sync_Run(1);
+
+    return NULL;
+}
+
+static void *_Worker(void *arg)
+{
+    uintptr_t worker = (uintptr_t)arg;
+
+    for (uint32_t i = 0; i < CALLS; i++)
+    {
+        uint32_t value = worker * CALLS + i;
+        ESP8266_AT_Arg args[1] = {{.u = value}};
+        ESP8266_AT_CmdId id = (ESP8266_AT_CmdId)(i % 5);
+        bool refused = i % 97 == 0;
+
+        ESP8266_AT_Result result = ESP8266_AT_Sync_Cmd(
+            i % 7 == 0 ? ESP8266_AT_PRIO_HIGH : ESP8266_AT_PRIO_NORMAL, id,
+            refused ? ESP8266_AT_EXEC : ESP8266_AT_SET, args, 1, 0, _Line, &value);
+
+        if (result != (refused ? ESP8266_AT_ERROR : _Expected(id)))
+            _Fail();
+    }
+
+    return NULL;
+}
+
+static void _TestStress(void)
+{
+    pthread_t driver;
+    pthread_t workers[WORKERS];
+
+    stop = false;
+    pthread_create(&driver, NULL, _Driver, NULL);
+    for (uintptr_t i = 0; i < WORKERS; i++)
+        pthread_create(&workers[i], NULL, _Worker, (void *)i);
+    for (int i = 0; i < WORKERS; i++)
+        pthread_join(workers[i], NULL);
+    stop = true;
+    pthread_join(driver, NULL);
+
+    ESP8266_AT_SyncStats stats;
+    ESP8266_AT_Sync_GetStats(&stats);
+    printf("  %u calls, longest wait %u ms\n", (unsigned)stats.calls, (unsigned)stats.max_ms);
+    CHECK(failures == 0);
+    CHECK(stats.no_waiter == 0);
+}
+
+int main(void)
+{
+    CHECK(ESP8266_AT_Sync_Init());
+
+    _TestHighPassesParked();
+    _TestStress();
+
+    return 0;
+}
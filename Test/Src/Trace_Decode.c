@@ -0,0 +1,105 @@
+/**
+ * Trace_Decode.c
+ * Host side decoder for the dumps ESP8266_Trace_Export writes, as laid
+ * out in ESP8266_AT_Trace.h. Prints one event per line:
+ *   <time ms> <+ms since previous> <dir> <command> <len or result> "<prefix>"
+ * Fields are read byte by byte, little endian, so the decoder does not
+ * depend on the host's struct layout.
+ *   Trace_Decode <dump file>     or the dump on standard input
+ */
+
+#include "ESP8266_AT_Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HEADER_LEN 8
+#define EVENT_LEN 12 // the version 1 record; a larger event size is skipped over
+
+static const char *const cmd_names[ESP8266_AT_CMD_COUNT] = {
+#define X(name, verb, forms, timeout, reply, required, params) #name,
+    ESP8266_AT_COMMANDS(X)
+#undef X
+    "OTHER",
+};
+
+static const char *const dir_names[] = {"TX", "RX", "URC", "RESULT", "DROP"};
+static const char *const result_names[] = {"PENDING", "OK", "ERROR", "TIMEOUT"};
+
+static uint32_t _U32(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void _Event(const uint8_t *event, uint32_t *last_ms)
+{
+    uint32_t time_ms = _U32(event);
+    uint8_t dir = event[4];
+    uint8_t cmd = event[5];
+    uint16_t len = event[6] | event[7] << 8;
+
+    printf("%10u %+7d %-6s %-12s ", (unsigned)time_ms, (int)(int32_t)(time_ms - *last_ms),
+           dir < sizeof(dir_names) / sizeof(dir_names[0]) ? dir_names[dir] : "?",
+           cmd < ESP8266_AT_CMD_COUNT ? cmd_names[cmd] : "?");
+    *last_ms = time_ms;
+
+    if (dir == ESP8266_TRACE_RESULT)
+    {
+        printf("%s\n", len < sizeof(result_names) / sizeof(result_names[0]) ? result_names[len]
+                                                                            : "?");
+        return;
+    }
+
+    printf("%5u \"", (unsigned)len);
+    for (uint8_t i = 0; i < 4 && i < len; i++)
+    {
+        uint8_t c = event[8 + i];
+        if (c == '\r')
+            printf("\\r");
+        else if (c == '\n')
+            printf("\\n");
+        else if (c == '"' || c == '\\')
+            printf("\\%c", c);
+        else if (c < ' ' || c > '~')
+            printf("\\x%02x", c);
+        else
+            putchar(c);
+    }
+    printf("%s\"\n", len > 4 ? "..." : "");
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = argc > 1 ? fopen(argv[1], "rb") : stdin;
+    if (in == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint8_t header[HEADER_LEN];
+    if (fread(header, 1, HEADER_LEN, in) != HEADER_LEN || header[0] != 'T' ||
+        header[1] != ESP8266_TRACE_VERSION || header[2] < EVENT_LEN)
+    {
+        fprintf(stderr, "not a version %d trace dump\n", ESP8266_TRACE_VERSION);
+        return 1;
+    }
+
+    uint8_t size = header[2];
+    uint32_t end = _U32(header + 4);
+    uint8_t event[255];
+    uint32_t count = 0;
+    uint32_t last_ms = 0;
+
+    for (; fread(event, 1, size, in) == size; count++)
+    {
+        if (count == 0)
+            last_ms = _U32(event);
+        _Event(event, &last_ms);
+    }
+    if (in != stdin)
+        fclose(in);
+
+    printf("%u events, %u lost to wrap-around\n", (unsigned)count,
+           (unsigned)(end >= count ? end - count : 0));
+    return 0;
+}